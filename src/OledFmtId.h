@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+#include <type_traits>
+
+// Compile-time format string ids.
+//
+// OLED_FMT_ID("...") folds a string literal to a 16-bit FNV-1a hash at build
+// time. Records carry the 2-byte id instead of a 4-byte pointer, and the host
+// side maps ids back to format strings with tools/oled_fmt_dict.py, which uses
+// the same hash. Id 0 is reserved for "no id" (plain logf calls).
+namespace OledFmtId {
+
+constexpr uint32_t FNV_OFFSET = 2166136261u;
+constexpr uint32_t FNV_PRIME  = 16777619u;
+
+// C++11 constexpr allows a single return statement, so walk the string recursively
+constexpr uint32_t fnv1a(const char* s, uint32_t h = FNV_OFFSET) {
+  return (*s == '\0') ? h : fnv1a(s + 1, (h ^ (uint8_t)*s) * FNV_PRIME);
+}
+
+// xor-fold to 16 bits (recommended over truncation for FNV), never 0
+constexpr uint16_t fold(uint32_t h) {
+  return ((h >> 16) ^ (h & 0xFFFFu)) ? (uint16_t)((h >> 16) ^ (h & 0xFFFFu)) : (uint16_t)1;
+}
+
+constexpr uint16_t id(const char* s) { return fold(fnv1a(s)); }
+
+} // namespace OledFmtId
+
+// integral_constant forces evaluation at compile time (fmt must be a literal)
+#define OLED_FMT_ID(fmt) (std::integral_constant<uint16_t, OledFmtId::id(fmt)>::value)
@@ -0,0 +1,354 @@
+#include "OledFormat.h"
+#include <algorithm> // for std::min
+#include <stdint.h>
+#include <string.h>
+
+namespace {
+
+const char LOWER_DIGITS[] = "0123456789abcdef";
+const char UPPER_DIGITS[] = "0123456789ABCDEF";
+
+const uint32_t POW10[] = {
+  1u, 10u, 100u, 1000u, 10000u, 100000u, 1000000u, 10000000u, 100000000u, 1000000000u
+};
+const int MAX_FLOAT_PREC = 9;
+
+// bounded writer: stops one byte short of the end to leave room for the NUL
+struct Out {
+  char* p;
+  char* end;
+  void put(char c) { if (p < end) *p++ = c; }
+  void fill(char c, int n) { while (n-- > 0) put(c); }
+  void put(const char* s, int n) { while (n-- > 0) put(*s++); }
+};
+
+struct Spec {
+  bool left;   // '-'
+  bool zero;   // '0'
+  bool plus;   // '+'
+  bool space;  // ' '
+  bool alt;    // '#'
+  int  width;
+  int  prec;   // -1 = not given
+};
+
+// sign (or + / space) for a converted number
+int signPrefix(char* pre, bool neg, const Spec& s)
+{
+  if (neg)     { pre[0] = '-'; return 1; }
+  if (s.plus)  { pre[0] = '+'; return 1; }
+  if (s.space) { pre[0] = ' '; return 1; }
+  return 0;
+}
+
+// prefix, zero fill and digits (most significant last in rev) with padding
+void emit(Out& o, const char* pre, int npre, int zeros, const char* rev, int n,
+          const char* tail, int ntail, Spec& s)
+{
+  int len = npre + zeros + n + ntail;
+  int pad = s.width > len ? s.width - len : 0;
+  if (s.zero && !s.left) {
+    zeros += pad;
+    pad = 0;
+  }
+  if (!s.left) o.fill(' ', pad);
+  o.put(pre, npre);
+  o.fill('0', zeros);
+  while (n > 0) o.put(rev[--n]);
+  o.put(tail, ntail);
+  if (s.left) o.fill(' ', pad);
+}
+
+void putInt(Out& o, uint64_t v, bool neg, unsigned base, bool upper, Spec& s)
+{
+  const char* dig = upper ? UPPER_DIGITS : LOWER_DIGITS;
+  const bool nonzero = v != 0;
+  char rev[24];
+  int n = 0;
+  // precision 0 with value 0 prints no digits at all
+  if (nonzero || s.prec != 0) {
+    do {
+      rev[n++] = dig[v % base];
+      v /= base;
+    } while (v);
+  }
+
+  char pre[3];
+  int npre = signPrefix(pre, neg, s);
+  int zeros = (s.prec > n) ? s.prec - n : 0;
+  if (s.alt && base == 16 && nonzero) {
+    pre[npre++] = '0';
+    pre[npre++] = upper ? 'X' : 'x';
+  } else if (s.alt && base == 8 && zeros == 0 && (n == 0 || rev[n - 1] != '0')) {
+    zeros = 1;
+  }
+  // an explicit precision disables the '0' flag for integers
+  if (s.prec >= 0) s.zero = false;
+  emit(o, pre, npre, zeros, rev, n, nullptr, 0, s);
+}
+
+void putFloat(Out& o, double x, bool upper, Spec& s)
+{
+  int prec = (s.prec < 0) ? 6 : s.prec;
+  int extra = 0; // requested digits beyond what is computed, printed as 0
+  if (prec > MAX_FLOAT_PREC) {
+    extra = prec - MAX_FLOAT_PREC;
+    prec = MAX_FLOAT_PREC;
+  }
+
+  char pre[1];
+  bool neg = (x < 0) || (x == 0 && 1 / x < 0); // -0.0 keeps its sign
+  if (neg) x = -x;
+  int npre = signPrefix(pre, neg, s);
+
+  // non-finite and out-of-range values: text, space padded
+  const char* word = nullptr;
+  if (x != x)                     word = upper ? "NAN" : "nan";
+  else if (x > 1.7976931348623157e308) word = upper ? "INF" : "inf";
+  else if (x >= 18446744073709551616.0) word = upper ? "OVF" : "ovf";
+  if (word) {
+    s.zero = false;
+    char rev[3] = { word[2], word[1], word[0] };
+    emit(o, pre, npre, 0, rev, 3, nullptr, 0, s);
+    return;
+  }
+
+  // fixed point: integer part and the fraction scaled to prec digits,
+  // rounded to nearest with the carry into the integer part. A product
+  // that lands on .5 is checked with fma: only exact ties go to even, as
+  // newlib/glibc do.
+  const uint32_t scale = POW10[prec];
+  uint64_t ip = (uint64_t)x;
+  double frac = x - (double)ip;
+  double r = frac * scale;
+  uint64_t fp = (uint64_t)r;
+  double rem = r - (double)fp;
+  if (rem == 0.5) {
+    double err = __builtin_fma(frac, (double)scale, -r);
+    uint64_t last = prec ? fp : ip;
+    if (err > 0 || (err == 0 && (last & 1))) ++fp;
+  } else if (rem > 0.5) {
+    ++fp;
+  }
+  if (fp >= scale) {
+    fp -= scale;
+    if (ip == UINT64_MAX) {
+      s.zero = false;
+      char rev[3] = { upper ? 'F' : 'f', upper ? 'V' : 'v', upper ? 'O' : 'o' };
+      emit(o, pre, npre, 0, rev, 3, nullptr, 0, s);
+      return;
+    }
+    ++ip;
+  }
+
+  char rev[24];
+  int n = 0;
+  do {
+    rev[n++] = (char)('0' + ip % 10);
+    ip /= 10;
+  } while (ip);
+
+  // '.', fraction digits (leading zeros kept), then zeros for any
+  // precision beyond MAX_FLOAT_PREC
+  char tail[48];
+  int ntail = 0;
+  extra = std::min(extra, (int)sizeof(tail) - 1 - MAX_FLOAT_PREC);
+  if (prec > 0 || extra > 0 || s.alt) tail[ntail++] = '.';
+  for (int d = prec - 1; d >= 0; --d) {
+    tail[ntail + d] = (char)('0' + fp % 10);
+    fp /= 10;
+  }
+  ntail += prec;
+  memset(tail + ntail, '0', extra);
+  ntail += extra;
+
+  emit(o, pre, npre, 0, rev, n, tail, ntail, s);
+}
+
+void putStr(Out& o, const char* str, Spec& s)
+{
+  if (!str) str = "(null)";
+  int n = 0;
+  while (str[n] && (s.prec < 0 || n < s.prec)) ++n;
+  int pad = s.width > n ? s.width - n : 0;
+  if (!s.left) o.fill(' ', pad);
+  o.put(str, n);
+  if (s.left) o.fill(' ', pad);
+}
+
+enum Length { LEN_INT, LEN_CHAR, LEN_SHORT, LEN_LONG, LEN_LLONG, LEN_SIZE, LEN_MAX, LEN_PTRDIFF,
+              LEN_LDOUBLE };
+
+} // namespace
+
+namespace OledFormat {
+
+int vformat(char* buf, size_t cap, const char* fmt, va_list ap)
+{
+  if (!buf || cap == 0) return 0;
+  Out o = { buf, buf + cap - 1 };
+
+  while (*fmt) {
+    if (*fmt != '%') {
+      // copy the literal run up to the next conversion
+      const char* lit = fmt;
+      while (*fmt && *fmt != '%') ++fmt;
+      o.put(lit, (int)(fmt - lit));
+      continue;
+    }
+    const char* start = fmt++;
+
+    Spec s = { false, false, false, false, false, 0, -1 };
+    for (;; ++fmt) {
+      if      (*fmt == '-') s.left = true;
+      else if (*fmt == '0') s.zero = true;
+      else if (*fmt == '+') s.plus = true;
+      else if (*fmt == ' ') s.space = true;
+      else if (*fmt == '#') s.alt = true;
+      else break;
+    }
+    if (*fmt == '*') {
+      s.width = va_arg(ap, int);
+      if (s.width < 0) {
+        s.left = true;
+        s.width = -s.width;
+      }
+      ++fmt;
+    } else {
+      while (*fmt >= '0' && *fmt <= '9') s.width = s.width * 10 + (*fmt++ - '0');
+    }
+    if (*fmt == '.') {
+      ++fmt;
+      s.prec = 0;
+      if (*fmt == '*') {
+        s.prec = va_arg(ap, int);
+        if (s.prec < 0) s.prec = -1;
+        ++fmt;
+      } else {
+        while (*fmt >= '0' && *fmt <= '9') s.prec = s.prec * 10 + (*fmt++ - '0');
+      }
+    }
+    if (s.left) s.zero = false;
+
+    Length len = LEN_INT;
+    if (*fmt == 'h') {
+      len = LEN_SHORT;
+      if (*++fmt == 'h') { len = LEN_CHAR; ++fmt; }
+    } else if (*fmt == 'l') {
+      len = LEN_LONG;
+      if (*++fmt == 'l') { len = LEN_LLONG; ++fmt; }
+    } else if (*fmt == 'z') {
+      len = LEN_SIZE; ++fmt;
+    } else if (*fmt == 'j') {
+      len = LEN_MAX; ++fmt;
+    } else if (*fmt == 't') {
+      len = LEN_PTRDIFF; ++fmt;
+    } else if (*fmt == 'L') {
+      len = LEN_LDOUBLE; ++fmt;
+    }
+
+    const char conv = *fmt;
+    if (conv) ++fmt;
+    switch (conv) {
+      case 'd':
+      case 'i': {
+        long long v;
+        switch (len) {
+          case LEN_CHAR:    v = (signed char)va_arg(ap, int); break;
+          case LEN_SHORT:   v = (short)va_arg(ap, int); break;
+          case LEN_LONG:    v = va_arg(ap, long); break;
+          case LEN_LLONG:   v = va_arg(ap, long long); break;
+          case LEN_SIZE:    v = (long long)va_arg(ap, size_t); break;
+          case LEN_MAX:     v = (long long)va_arg(ap, intmax_t); break;
+          case LEN_PTRDIFF: v = (long long)va_arg(ap, ptrdiff_t); break;
+          default:          v = va_arg(ap, int); break;
+        }
+        // negate in unsigned so LLONG_MIN does not overflow
+        uint64_t mag = (v < 0) ? 0 - (uint64_t)v : (uint64_t)v;
+        putInt(o, mag, v < 0, 10, false, s);
+        break;
+      }
+      case 'u':
+      case 'x':
+      case 'X':
+      case 'o': {
+        uint64_t v;
+        switch (len) {
+          case LEN_CHAR:    v = (unsigned char)va_arg(ap, unsigned); break;
+          case LEN_SHORT:   v = (unsigned short)va_arg(ap, unsigned); break;
+          case LEN_LONG:    v = va_arg(ap, unsigned long); break;
+          case LEN_LLONG:   v = va_arg(ap, unsigned long long); break;
+          case LEN_SIZE:    v = va_arg(ap, size_t); break;
+          case LEN_MAX:     v = (uint64_t)va_arg(ap, uintmax_t); break;
+          case LEN_PTRDIFF: v = (uint64_t)va_arg(ap, ptrdiff_t); break;
+          default:          v = va_arg(ap, unsigned); break;
+        }
+        s.plus = s.space = false;
+        unsigned base = (conv == 'u') ? 10 : (conv == 'o') ? 8 : 16;
+        putInt(o, v, false, base, conv == 'X', s);
+        break;
+      }
+      case 'p': {
+        uintptr_t v = (uintptr_t)va_arg(ap, void*);
+        s.alt = true;
+        s.plus = s.space = false;
+        putInt(o, v, false, 16, false, s);
+        break;
+      }
+      case 'c': {
+        char c = (char)va_arg(ap, int);
+        int pad = s.width > 1 ? s.width - 1 : 0;
+        if (!s.left) o.fill(' ', pad);
+        o.put(c);
+        if (s.left) o.fill(' ', pad);
+        break;
+      }
+      case 's':
+        putStr(o, va_arg(ap, const char*), s);
+        break;
+      case 'f':
+      case 'F': {
+        double v = (len == LEN_LDOUBLE) ? (double)va_arg(ap, long double) : va_arg(ap, double);
+        putFloat(o, v, conv == 'F', s);
+        break;
+      }
+      case '%':
+        o.put('%');
+        break;
+      case 'e':
+      case 'E':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A':
+        // unsupported, copied through; the argument is still consumed so
+        // the ones after it line up
+        if (len == LEN_LDOUBLE) (void)va_arg(ap, long double);
+        else                    (void)va_arg(ap, double);
+        o.put(start, (int)(fmt - start));
+        break;
+      case 'n':
+        (void)va_arg(ap, void*);
+        o.put(start, (int)(fmt - start));
+        break;
+      default:
+        // unknown conversion: copy the directive through unchanged
+        o.put(start, (int)(fmt - start));
+        break;
+    }
+  }
+
+  *o.p = '\0';
+  return (int)(o.p - buf);
+}
+
+int format(char* buf, size_t cap, const char* fmt, ...)
+{
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vformat(buf, cap, fmt, ap);
+  va_end(ap);
+  return n;
+}
+
+} // namespace OledFormat
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+
+// Compact printf subset for log records, used by logf when
+// OLED_LOGGER_COMPACT_FORMAT is 1. No locale, no reentrancy locks and no
+// newlib dtoa: %f is done in 64-bit integer arithmetic.
+//
+// Supported: %d %i %u %x %X %o %c %s %p %f %F %%, flags - 0 + space #,
+// width and precision (also as *), length modifiers hh h l ll z j t (and L
+// for %f, printed at double precision).
+// Differences from vsnprintf:
+//  - %f precision is capped at 9 digits (further digits print as 0) and
+//    magnitudes above ~1.8e19 print as "ovf"; the last digit may differ
+//    when scaling the fraction by 10^precision rounds across a .5 boundary
+//  - %e %g %a and %n are not supported and are copied through verbatim;
+//    their argument is consumed, so later conversions still line up
+//  - the return value is the number of characters stored, not the length
+//    the untruncated output would have had
+namespace OledFormat {
+
+// format into buf (always NUL-terminated when cap > 0)
+int vformat(char* buf, size_t cap, const char* fmt, va_list ap);
+int format(char* buf, size_t cap, const char* fmt, ...);
+
+} // namespace OledFormat
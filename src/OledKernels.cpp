@@ -0,0 +1,113 @@
+#include "OledKernels.h"
+#include <string.h>
+
+namespace {
+
+// word view of byte buffers (framebuffer rows are plain uint8_t arrays)
+typedef uint32_t __attribute__((__may_alias__)) word_t;
+
+inline bool aligned(const void* p, size_t a)
+{
+  return ((uintptr_t)p & (a - 1)) == 0;
+}
+
+// same offset within a word, so both reach a word boundary together
+inline bool sameAlign(const void* a, const void* b, size_t n)
+{
+  return (((uintptr_t)a ^ (uintptr_t)b) & (n - 1)) == 0;
+}
+
+// index of the first byte where a and b differ, n if none
+size_t firstDiff(const uint8_t* a, const uint8_t* b, size_t n)
+{
+  size_t i = 0;
+  if (sameAlign(a, b, 4)) {
+    for (; i < n && !aligned(a + i, 4); ++i) {
+      if (a[i] != b[i]) return i;
+    }
+    // the byte loop below finds the byte inside a differing word
+    for (; i + 4 <= n; i += 4) {
+      if (*(const word_t*)(a + i) != *(const word_t*)(b + i)) break;
+    }
+  }
+  for (; i < n; ++i) {
+    if (a[i] != b[i]) return i;
+  }
+  return n;
+}
+
+// index of the last byte where a and b differ, n if none
+size_t lastDiff(const uint8_t* a, const uint8_t* b, size_t n)
+{
+  size_t i = n; // bytes [i, n) are equal
+  if (sameAlign(a, b, 4)) {
+    for (; i > 0 && !aligned(a + i, 4); --i) {
+      if (a[i - 1] != b[i - 1]) return i - 1;
+    }
+    for (; i >= 4; i -= 4) {
+      if (*(const word_t*)(a + i - 4) != *(const word_t*)(b + i - 4)) break;
+    }
+  }
+  for (; i > 0; --i) {
+    if (a[i - 1] != b[i - 1]) return i - 1;
+  }
+  return n;
+}
+
+} // namespace
+
+namespace OledKernels {
+
+void fill(uint8_t* dst, uint8_t value, size_t n)
+{
+  const uint32_t word = value * 0x01010101u;
+  for (; n && !aligned(dst, 4); --n) *dst++ = value;
+  for (; n >= 4; n -= 4, dst += 4) *(word_t*)dst = word;
+  while (n--) *dst++ = value;
+}
+
+void copy(uint8_t* dst, const uint8_t* src, size_t n)
+{
+  // the word loop needs both pointers aligned at the same time
+  if (!sameAlign(dst, src, 4)) {
+    memcpy(dst, src, n);
+    return;
+  }
+  for (; n && !aligned(dst, 4); --n) *dst++ = *src++;
+  for (; n >= 4; n -= 4, dst += 4, src += 4) *(word_t*)dst = *(const word_t*)src;
+  while (n--) *dst++ = *src++;
+}
+
+void invert(uint8_t* dst, size_t n)
+{
+  for (; n && !aligned(dst, 4); --n, ++dst) *dst = (uint8_t)~*dst;
+  for (; n >= 4; n -= 4, dst += 4) *(word_t*)dst = ~*(word_t*)dst;
+  for (; n; --n, ++dst) *dst = (uint8_t)~*dst;
+}
+
+void maskAlternate(uint8_t* dst, size_t n, uint8_t even, uint8_t odd)
+{
+  // the head can be an odd number of bytes, so track the index parity
+  size_t i = 0;
+  for (; i < n && !aligned(dst + i, 4); ++i) dst[i] &= (i & 1) ? odd : even;
+
+  // every aligned word starts at the same parity as i
+  const uint8_t m0 = (i & 1) ? odd : even;
+  const uint8_t m1 = (i & 1) ? even : odd;
+  const uint8_t bytes[4] = { m0, m1, m0, m1 };
+  uint32_t word;
+  memcpy(&word, bytes, sizeof(word));
+  for (; i + 4 <= n; i += 4) *(word_t*)(dst + i) &= word;
+  for (; i < n; ++i) dst[i] &= (i & 1) ? odd : even;
+}
+
+bool diff(const uint8_t* a, const uint8_t* b, size_t n, size_t* first, size_t* last)
+{
+  size_t lo = firstDiff(a, b, n);
+  if (lo == n) return false;
+  if (first) *first = lo;
+  if (last) *last = lo + lastDiff(a + lo, b + lo, n - lo);
+  return true;
+}
+
+} // namespace OledKernels
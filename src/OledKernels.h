@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Framebuffer row kernels used by the renderer: clears, copies, inverts,
+// the checkerboard dim and row diffs. They work on aligned 32-bit words
+// with byte loops for the unaligned head and tail.
+
+namespace OledKernels {
+
+// dst[0..n) = value
+void fill(uint8_t* dst, uint8_t value, size_t n);
+// dst[0..n) = src[0..n), no overlap
+void copy(uint8_t* dst, const uint8_t* src, size_t n);
+// dst[i] = ~dst[i]
+void invert(uint8_t* dst, size_t n);
+// dst[i] &= (i even ? even : odd), e.g. 0x55/0xAA for a checkerboard
+void maskAlternate(uint8_t* dst, size_t n, uint8_t even, uint8_t odd);
+// true if a and b differ; first/last (either may be nullptr) get the
+// first and last differing index
+bool diff(const uint8_t* a, const uint8_t* b, size_t n, size_t* first, size_t* last);
+
+} // namespace OledKernels
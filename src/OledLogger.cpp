@@ -1,20 +1,171 @@
 // OledLogger.cpp  -- patched for deterministic, artifact-free rendering
 #include "OledLogger.h"
+#include "OledFormat.h"
+#include "OledKernels.h"
 #include <algorithm> // for std::min/std::max
 #include <string.h>  // for strncpy
+#include <stddef.h>  // for offsetof
 #include <Arduino.h>
+#include <esp_heap_caps.h>
+
+// SSD1306 I2C control bytes and addressing commands
+#define OLED_CTRL_CMD      0x00 // Co=0: command bytes until STOP
+#define OLED_CTRL_CMD_ONE  0x80 // Co=1: one command byte, then another control byte
+#define OLED_CTRL_DATA     0x40 // Co=0 D/C=1: data bytes until STOP
+#define OLED_CMD_COLADDR   0x21
+#define OLED_CMD_PAGEADDR  0x22
+
+// Wire transmit buffer size when it cannot be enlarged (ESP32 core defines I2C_BUFFER_LENGTH)
+#ifdef I2C_BUFFER_LENGTH
+#define OLED_WIRE_MAX I2C_BUFFER_LENGTH
+#else
+#define OLED_WIRE_MAX 32
+#endif
+
+// I2C bus clock; a safe rate, many cheap modules misbehave at 400 kHz
+#define OLED_I2C_CLOCK 100000
+
+// widget column patterns (bit 0 = top pixel row of the page)
+#define WIDGET_BAR_END    0x7E // end caps and filled columns
+#define WIDGET_BAR_EMPTY  0x42 // outline only
+#define WIDGET_GAUGE_AXIS 0x08 // thin midline
+#define WIDGET_GAUGE_NEEDLE 0x7F
+#define WIDGET_GAUGE_NEEDLE_W 2
 
 // Static member definitions
+volatile uint8_t  OledLogger::_minLevel = OledLogger::LEVEL_DEBUG;
+volatile uint32_t OledLogger::_tagMask[8] = {
+  0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu,
+  0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu
+};
+volatile uint16_t OledLogger::_rateLimit = 0;
+uint32_t          OledLogger::_rateSecond = 0;
+uint32_t          OledLogger::_rateCount = 0;
 TaskHandle_t      OledLogger::_taskHandle = nullptr;
+#if OLED_LOGGER_TRANSPORT == OLED_TRANSPORT_RINGBUF
+RingbufHandle_t   OledLogger::_queue = nullptr;
+volatile bool     OledLogger::_held = false;
+#else
 QueueHandle_t     OledLogger::_queue = nullptr;
-Adafruit_SSD1306* OledLogger::_display = nullptr;
+#endif
+uint8_t*          OledLogger::_fb = nullptr;
+uint32_t          OledLogger::_beginUs = 0;
+bool              OledLogger::_started = false;
+bool              OledLogger::_framePending = false;
+size_t            OledLogger::_cacheWant = 0;
+TickType_t        OledLogger::_probeInterval = pdMS_TO_TICKS(OledLogger::PROBE_MS);
+TickType_t        OledLogger::_nextProbe = 0;
+uint16_t          OledLogger::_dirtyPages = 0;
 int               OledLogger::_width = 128;
 int               OledLogger::_height = 64;
 uint8_t           OledLogger::_i2c_addr = 0x3C;
 size_t            OledLogger::_queue_len = 16;
+size_t            OledLogger::_wireMax = OLED_WIRE_MAX;
+OledLogger::Stats OledLogger::_stats = {};
+OledLogger::line_t OledLogger::_lines[OledLogger::MAX_LINES];
+int               OledLogger::_numLines = 1;
+int               OledLogger::_writeIndex = -1;
+bool              OledLogger::_linesChanged = false;
+TickType_t        OledLogger::_levelTtl[OledLogger::LEVEL_COUNT] = {};
+OledLogger::ExpiryMode OledLogger::_expiryMode = OledLogger::EXPIRE_BLANK;
+OledLogger::widget_t OledLogger::_widgets[OledLogger::MAX_WIDGETS];
+volatile int      OledLogger::_numWidgets = 0;
+uint16_t          OledLogger::_reservedPages = 0;
+OledLogger::watch_t OledLogger::_watches[OledLogger::MAX_WATCHES];
+volatile int      OledLogger::_numWatches = 0;
+TickType_t        OledLogger::_nextWatch = 0;
+OledLogger::histogram_t OledLogger::_hists[OledLogger::MAX_HISTOGRAMS];
+volatile int      OledLogger::_numHists = 0;
+TickType_t        OledLogger::_nextHist = 0;
+uint8_t           OledLogger::_monPages[OledLogger::MONITOR_MAX_ROWS];
+uint32_t          OledLogger::_monDrawn[OledLogger::MONITOR_MAX_ROWS];
+volatile int      OledLogger::_monRows = 0;
+uint8_t           OledLogger::_monPct = 1;
+uint32_t          OledLogger::_monInterval = OledLogger::MONITOR_MIN_MS;
+TickType_t        OledLogger::_nextMon = 0;
+OledLogger::subscriber_t OledLogger::_subs[OledLogger::MAX_SUBSCRIBERS];
+volatile int      OledLogger::_numSubs = 0;
+#if OLED_LOGGER_PROFILE_SITES
+OledLogger::site_t OledLogger::_sites[OledLogger::MAX_SITES];
+uint8_t           OledLogger::_sitePages[OledLogger::MONITOR_MAX_ROWS];
+uint32_t          OledLogger::_siteDrawn[OledLogger::MONITOR_MAX_ROWS];
+volatile int      OledLogger::_siteRows = 0;
+TickType_t        OledLogger::_nextSites = 0;
+#endif
+#if OLED_MONITOR_TASK_STATS
+TaskStatus_t*     OledLogger::_monTasks = nullptr;
+TaskStatus_t*     OledLogger::_monPrev = nullptr;
+UBaseType_t       OledLogger::_monCap = 0;
+UBaseType_t       OledLogger::_monPrevCount = 0;
+uint32_t          OledLogger::_monPrevTotal = 0;
+#endif
+
+// built-in inline icons, selected by the OLED_ICON_* codes
+static const OledIcon BUILTIN_ICONS[] = {
+  { 8, { 0x08, 0x14, 0x4A, 0xAA, 0x4A, 0x14, 0x08, 0x00 } }, // WIFI
+  { 8, { 0x3C, 0x7E, 0x7E, 0x7E, 0x7E, 0x7E, 0x3C, 0x00 } }, // BATTERY_FULL
+  { 8, { 0x3C, 0x72, 0x42, 0x42, 0x42, 0x42, 0x3C, 0x00 } }, // BATTERY_LOW
+  { 8, { 0xE0, 0x98, 0x86, 0xD9, 0x86, 0x98, 0xE0, 0x00 } }, // WARNING
+  { 8, { 0x3E, 0x41, 0x55, 0x49, 0x55, 0x41, 0x3E, 0x00 } }, // ERROR
+  { 8, { 0x08, 0x10, 0x20, 0x10, 0x08, 0x04, 0x02, 0x00 } }, // OK
+  { 8, { 0x3E, 0x41, 0x41, 0x7B, 0x41, 0x41, 0x3E, 0x00 } }, // INFO
+  { 8, { 0x08, 0x04, 0x02, 0x7F, 0x02, 0x04, 0x08, 0x00 } }, // UP
+  { 8, { 0x08, 0x10, 0x20, 0x7F, 0x20, 0x10, 0x08, 0x00 } }, // DOWN
+  { 8, { 0x3E, 0x41, 0x41, 0x4F, 0x49, 0x41, 0x3E, 0x00 } }, // CLOCK
+  { 8, { 0x20, 0x3C, 0x22, 0x63, 0x22, 0x3C, 0x20, 0x00 } }, // BELL
+  { 8, { 0x78, 0x7E, 0x79, 0x49, 0x79, 0x7E, 0x78, 0x00 } }, // LOCK
+};
+
+uint8_t*          OledLogger::_cacheRows = nullptr;
+OledLogger::raster_key_t* OledLogger::_cacheKeys = nullptr;
+size_t            OledLogger::_cacheSize = 0;
+uint32_t          OledLogger::_cacheClock = 0;
+
+const OledIcon*   OledLogger::_icons = BUILTIN_ICONS;
+uint8_t           OledLogger::_iconCount = sizeof(BUILTIN_ICONS) / sizeof(BUILTIN_ICONS[0]);
+
+OledLogger::msg_t* OledLogger::_hist = nullptr;
+size_t            OledLogger::_histCap = 0;
+uint32_t          OledLogger::_histSeq = 0;
+volatile uint32_t OledLogger::_ctlQueued = 0;
+char              OledLogger::_blockText[OledLogger::BLOCK_SLOTS][OledLogger::BLOCK_TEXT];
+volatile uint32_t OledLogger::_blockBusy = 0;
+uint8_t           OledLogger::_capState = OledLogger::CAP_LIVE;
+OledLogger::capture_t OledLogger::_cap = {};
+uint32_t          OledLogger::_capTrigSeq = 0;
+uint16_t          OledLogger::_capPostLeft = 0;
+OledLogger::hist_link_t* OledLogger::_histLinks = nullptr;
+uint32_t*         OledLogger::_levelBits = nullptr;
+size_t            OledLogger::_histWords = 0;
+uint32_t*         OledLogger::_tagHead = nullptr;
+OledLogger::view_t OledLogger::_view = {};
+uint32_t          OledLogger::_viewTop = OledLogger::NO_SEQ;
+bool              OledLogger::_viewDirty = false;
+
+// nibble -> hex digit table for dump formatting
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+// FNV-1a over a line of text (same hash family as the format ids)
+static uint32_t hashText(const char* txt, uint16_t* len)
+{
+  uint32_t h = OledFmtId::FNV_OFFSET;
+  uint16_t n = 0;
+  for (const char* c = txt; *c; ++c, ++n) h = (h ^ (uint8_t)*c) * OledFmtId::FNV_PRIME;
+  if (len) *len = n;
+  return h;
+}
 
 bool OledLogger::isReady() {
-  return (_queue != nullptr) && (_display != nullptr);
+  return _queue != nullptr;
+}
+
+bool OledLogger::isHeadless() {
+  return (_queue != nullptr) && (_fb == nullptr);
+}
+
+void OledLogger::setPanelProbe(uint32_t interval_ms)
+{
+  _probeInterval = interval_ms ? std::max((TickType_t)1, (TickType_t)pdMS_TO_TICKS(interval_ms)) : 0;
 }
 
 bool OledLogger::begin(uint8_t i2c_addr,
@@ -24,55 +175,74 @@ bool OledLogger::begin(uint8_t i2c_addr,
                        int scl_pin,
                        size_t queue_len,
                        UBaseType_t task_priority,
-                       BaseType_t pinned_core)
+                       BaseType_t pinned_core,
+                       bool create_task,
+                       size_t raster_cache_lines)
 {
+  _beginUs = micros();
+
   // store config
   _i2c_addr = i2c_addr;
   _width = width;
   _height = height;
   _queue_len = (queue_len < 1) ? 1 : queue_len;
 
+  // create queue first: logf accepts messages while the panel is brought up
+  if (!createTransport()) {
+    Serial.println("OLED QUEUE creation failed");
+    return false;
+  }
+
+  // Grow the Wire buffer so a whole frame plus its addressing header goes out
+  // in one transaction (must happen before Wire.begin()). If the bus is
+  // already running or the core lacks setBufferSize, flushes are chunked.
+  _wireMax = OLED_WIRE_MAX;
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 2
+  {
+    size_t want = 16 + (size_t)_width * (_height / 8);
+    if (Wire.setBufferSize(want) == want) _wireMax = want;
+  }
+#endif
+
   // init Wire (only set pins if valid)
   if (sda_pin >= 0 && scl_pin >= 0) {
     Wire.begin((int)sda_pin, (int)scl_pin);
   } else {
     Wire.begin();
   }
-  // Use safe I2C clock (many cheap modules misbehave at 400kHz)
-  Wire.setClock(100000);
+  Wire.setClock(OLED_I2C_CLOCK);
 
-  // allocate display instance
-  _display = new Adafruit_SSD1306((uint8_t)_width, (uint8_t)_height, &Wire, -1);
-  if (!_display) {
-    Serial.println("OLED: memory allocation failed");
-    return false;
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 2
+  // Wire aborts a transaction that outlasts its timeout (50 ms by default),
+  // and a whole frame takes ~94 ms at 100 kHz. Cap transactions at what
+  // half the timeout carries, 9 clocks per byte.
+  {
+    // at least the addressing header and some data
+    size_t fits = (size_t)Wire.getTimeOut() * (OLED_I2C_CLOCK / 1000) / 9 / 2;
+    _wireMax = std::min(_wireMax, std::max(fits, (size_t)32));
   }
+#endif
 
-  if (!_display->begin(SSD1306_SWITCHCAPVCC, _i2c_addr)) {
-    Serial.println("OLED INIT FAILED");
-    delete _display;
-    _display = nullptr;
+  // no panel on the bus: run headless and keep probing for one
+  _cacheWant = raster_cache_lines;
+  if (!probePanel()) {
+    Serial.println("OLED: no panel, running headless");
+    _nextProbe = xTaskGetTickCount() + _probeInterval;
+  } else if (!attachPanel()) {
+    deleteTransport();
     return false;
   }
 
-  // Stable, deterministic display config
-  _display->clearDisplay();
-  _display->setRotation(0);
-  _display->setTextSize(1);                 // fixed text size
-  _display->setTextColor(SSD1306_WHITE);    // draw white pixels
-  _display->cp437(false);                   // normal ASCII mapping (avoid CP437 remap)
-  _display->setTextWrap(false);             // we handle wrap/clip manually
-  _display->display();
-  // removed _display->setContrast(0xFF);  <-- not available in this Adafruit SSD1306 build
+  // Compute how many lines fit on the display (8 px per line), clamp to MAX_LINES
+  _numLines = std::max(1, std::min(_height / 8, (int)MAX_LINES));
+  clearLines(); // newest message index (circular) starts at -1
+  _linesChanged = false;
+  _started = false;
+  _framePending = false;
+  _dirtyPages = 0;
 
-  // create queue
-  _queue = xQueueCreate((UBaseType_t)_queue_len, sizeof(msg_t));
-  if (!_queue) {
-    Serial.println("OLED QUEUE creation failed");
-    delete _display;
-    _display = nullptr;
-    return false;
-  }
+  // polled mode: service() does the render task's work from the app's loop
+  if (!create_task) return true;
 
   // create task
   BaseType_t created = xTaskCreatePinnedToCore(
@@ -86,130 +256,2157 @@ bool OledLogger::begin(uint8_t i2c_addr,
 
   if (created != pdPASS) {
     Serial.println("OLED task creation failed");
-    vQueueDelete(_queue);
-    _queue = nullptr;
-    delete _display;
-    _display = nullptr;
+    deleteTransport();
+    free(_fb);
+    _fb = nullptr;
+    free(_cacheRows);
+    free(_cacheKeys);
+    _cacheRows = nullptr;
+    _cacheKeys = nullptr;
+    _cacheSize = 0;
+    return false;
+  }
+
+  return true;
+}
+
+bool OledLogger::panelInit()
+{
+  // SSD1306 bring-up for the internal charge pump (SWITCHCAPVCC), sent as a
+  // single command transaction. The display stays off: the render task's
+  // first frame overwrites all of panel RAM and then turns it on, so there
+  // is no separate blank-frame flush.
+  const bool tall = _height > 32;
+  const uint8_t init[] = {
+    0xAE,                          // display off
+    0xD5, 0x80,                    // clock divide / oscillator
+    0xA8, (uint8_t)(_height - 1),  // multiplex ratio
+    0xD3, 0x00,                    // display offset
+    0x40,                          // start line 0
+    0x8D, 0x14,                    // charge pump on
+    0x20, 0x00,                    // horizontal addressing
+    0xA1,                          // segment remap
+    0xC8,                          // COM scan descending
+    0xDA, (uint8_t)(tall ? 0x12 : 0x02), // COM pins
+    0x81, (uint8_t)(tall ? 0xCF : 0x8F), // contrast
+    0xD9, 0xF1,                    // precharge
+    0xDB, 0x40,                    // VCOMH deselect
+    0xA4,                          // output follows RAM
+    0xA6,                          // normal (not inverted)
+    0x2E                           // scrolling off
+  };
+  return sendCommands(init, sizeof(init));
+}
+
+bool OledLogger::probePanel()
+{
+  Wire.beginTransmission(_i2c_addr);
+  uint8_t err = Wire.endTransmission();
+
+  _stats.i2c_transactions++;
+  _stats.i2c_overhead_bytes += 1; // address only
+  return err == 0;
+}
+
+bool OledLogger::attachPanel()
+{
+  // allocate framebuffer (zeroed: it doubles as the blank first frame)
+  _fb = (uint8_t*)calloc((size_t)_width * (_height / 8), 1);
+  if (!_fb) {
+    Serial.println("OLED: memory allocation failed");
+    return false;
+  }
+
+  if (!panelInit()) {
+    Serial.println("OLED INIT FAILED");
+    free(_fb);
+    _fb = nullptr;
     return false;
   }
 
+  // optional raster cache; logging works without it if allocation fails
+  if (_cacheWant && !_cacheSize) {
+    _cacheRows = (uint8_t*)malloc(_cacheWant * _width);
+    _cacheKeys = (raster_key_t*)calloc(_cacheWant, sizeof(raster_key_t));
+    if (_cacheRows && _cacheKeys) {
+      _cacheSize = _cacheWant;
+    } else {
+      Serial.println("OLED: raster cache allocation failed");
+      free(_cacheRows);
+      free(_cacheKeys);
+      _cacheRows = nullptr;
+      _cacheKeys = nullptr;
+    }
+  }
+
+  // the render task (or service()) sends the first frame next
+  _started = false;
+  _framePending = false;
+  _dirtyPages = 0;
+  return true;
+}
+
+void OledLogger::pollPanel()
+{
+  if (!_probeInterval) return;
+  TickType_t now = xTaskGetTickCount();
+  if ((int32_t)(now - _nextProbe) < 0) return;
+  _nextProbe = now + _probeInterval;
+  if (probePanel() && attachPanel()) Serial.println("OLED: panel attached");
+}
+
+void OledLogger::startFrame(msg_t& scratch)
+{
+  // whatever was logged during begin() is drawn into the first frame,
+  // which also replaces the blank clear of panel RAM
+  while (const msg_t* m = receive(scratch, 0)) consume(m);
+  drawLines();
+  _linesChanged = false;
+  // full frame (blank rows plus whatever was logged during startup)
+  _dirtyPages = (uint16_t)((1u << (_height / 8)) - 1);
+  _framePending = true;
+}
+
+void OledLogger::displayOn()
+{
+  // the whole first frame is in panel RAM: turn the display on
+  const uint8_t on = 0xAF;
+  sendCommands(&on, 1);
+  _stats.startup_us = micros() - _beginUs;
+  _framePending = false;
+  _started = true;
+}
+
+#if OLED_LOGGER_TRANSPORT == OLED_TRANSPORT_RINGBUF
+
+// Ring buffer transport: variable-length items, NOSPLIT so each record is
+// contiguous and can be read in place. Each item costs its used bytes plus
+// the ring buffer's 8-byte item header, rounded up to 4 bytes.
+static const size_t RINGBUF_ITEM_HEADER = 8;
+// oldest records one send may drop to make room: a full-length record
+// needs four of the shortest, more when the free space wraps
+static const int RINGBUF_MAX_DROPS = 8;
+
+// records waiting to be received; vRingbufferGetInfo() gained an acquire
+// pointer argument in IDF 4.x, this picks whichever signature it has
+static inline UBaseType_t ringWaiting(void (*info)(RingbufHandle_t, UBaseType_t*, UBaseType_t*,
+                                                   UBaseType_t*, UBaseType_t*),
+                                      RingbufHandle_t rb)
+{
+  UBaseType_t n = 0;
+  info(rb, nullptr, nullptr, nullptr, &n);
+  return n;
+}
+
+static inline UBaseType_t ringWaiting(void (*info)(RingbufHandle_t, UBaseType_t*, UBaseType_t*,
+                                                   UBaseType_t*, UBaseType_t*, UBaseType_t*),
+                                      RingbufHandle_t rb)
+{
+  UBaseType_t n = 0;
+  info(rb, nullptr, nullptr, nullptr, nullptr, &n);
+  return n;
+}
+
+bool OledLogger::createTransport()
+{
+  // queue_len full records with their headers; a NOSPLIT item may use at
+  // most half the ring, so never less than two
+  const size_t item = (sizeof(msg_t) + RINGBUF_ITEM_HEADER + 3) & ~(size_t)3;
+  _queue = xRingbufferCreate(std::max(_queue_len, (size_t)2) * item, RINGBUF_TYPE_NOSPLIT);
+  if (!_queue) return false;
+  if (xRingbufferGetMaxItemSize(_queue) < sizeof(msg_t)) {
+    // a full-length record could never be sent
+    deleteTransport();
+    return false;
+  }
   return true;
 }
 
-void OledLogger::sendOrDropOldest(const msg_t &m)
+void OledLogger::deleteTransport()
+{
+  vRingbufferDelete(_queue);
+  _queue = nullptr;
+}
+
+bool OledLogger::sendOrDropOldest(const msg_t &m, bool* sent)
+{
+  size_t size = recordSize(m);
+  if (sent) *sent = true;
+  if (xRingbufferSend(_queue, &m, size, 0) == pdTRUE) return true;
+  if (sent) *sent = false;
+
+  // Space is freed in order, up to the oldest item not yet returned: while
+  // the render side holds one (e.g. a subscriber logging from consume()),
+  // dropping older records frees nothing.
+  if (_held) return false;
+
+  // Ring full: drop oldest records until this one fits (drop oldest policy).
+  // Several short records may have to go to make room for a long one, but
+  // at most RINGBUF_MAX_DROPS, and never the last one waiting.
+  for (int i = 0; i < RINGBUF_MAX_DROPS; ++i) {
+    // the oldest record may be a capture/view command: drop this one instead
+    if (__atomic_load_n(&_ctlQueued, __ATOMIC_ACQUIRE)) break;
+    if (ringWaiting(vRingbufferGetInfo, _queue) < 2) break;
+
+    const size_t freeBefore = xRingbufferGetCurFreeSize(_queue);
+    size_t oldSize;
+    void* old = xRingbufferReceive(_queue, &oldSize, 0);
+    if (!old) break;
+    if (((const msg_t*)old)->kind == MSG_CONTROL) {
+      // queued after the check above: it goes back, this record goes
+      msg_t ctl;
+      memcpy(&ctl, old, std::min(oldSize, sizeof(ctl)));
+      vRingbufferReturnItem(_queue, old);
+      requeueControl(ctl);
+      break;
+    }
+    releaseBlock(*(const msg_t*)old);
+    vRingbufferReturnItem(_queue, old);
+    if (xRingbufferSend(_queue, &m, size, 0) == pdTRUE) {
+      if (sent) *sent = true;
+      break;
+    }
+    // the render task took a record meanwhile: more drops would only
+    // empty the ring
+    if (xRingbufferGetCurFreeSize(_queue) <= freeBefore) break;
+  }
+  return false;
+}
+
+bool OledLogger::sendWait(const msg_t &m, TickType_t wait)
+{
+  return xRingbufferSend(_queue, &m, recordSize(m), wait) == pdTRUE;
+}
+
+static BaseType_t IRAM_ATTR transportSendFromISR(RingbufHandle_t rb, const void* m, size_t size, BaseType_t* woken)
+{
+  return xRingbufferSendFromISR(rb, m, size, woken);
+}
+
+const OledLogger::msg_t* OledLogger::receive(msg_t& scratch, TickType_t wait)
+{
+  (void)scratch;
+  size_t size;
+  const msg_t* m = (const msg_t*)xRingbufferReceive(_queue, &size, wait);
+  if (m) _held = true;
+  return m;
+}
+
+void OledLogger::release(const msg_t* m)
+{
+  vRingbufferReturnItem(_queue, (void*)m);
+  _held = false;
+}
+
+#else
+
+// Queue transport: fixed sizeof(msg_t) items, copied in and out.
+
+bool OledLogger::createTransport()
+{
+  _queue = xQueueCreate((UBaseType_t)_queue_len, sizeof(msg_t));
+  return _queue != nullptr;
+}
+
+void OledLogger::deleteTransport()
+{
+  vQueueDelete(_queue);
+  _queue = nullptr;
+}
+
+bool OledLogger::sendOrDropOldest(const msg_t &m, bool* sent)
 {
-  if (xQueueSend(_queue, &m, 0) == pdTRUE) return;
+  if (sent) *sent = true;
+  if (xQueueSend(_queue, &m, 0) == pdTRUE) return true;
+  if (sent) *sent = false;
+
+  // the oldest record may be a capture/view command: drop this one instead
+  if (__atomic_load_n(&_ctlQueued, __ATOMIC_ACQUIRE)) return false;
 
   // Queue full: remove one oldest entry and try again (drop oldest policy)
   msg_t tmp;
-  if (xQueueReceive(_queue, &tmp, 0) == pdTRUE) {
-    // dropped
+  if (xQueueReceive(_queue, &tmp, 0) == pdTRUE && tmp.kind == MSG_CONTROL) {
+    // queued after the check above: it goes back, this record goes
+    requeueControl(tmp);
+    return false;
   }
-  xQueueSend(_queue, &m, 0);
+  releaseBlock(tmp);
+  if (xQueueSend(_queue, &m, 0) == pdTRUE && sent) *sent = true;
+  return false;
 }
 
-void OledLogger::logf(const char* fmt, ...)
+bool OledLogger::sendWait(const msg_t &m, TickType_t wait)
+{
+  return xQueueSend(_queue, &m, wait) == pdTRUE;
+}
+
+static BaseType_t IRAM_ATTR transportSendFromISR(QueueHandle_t q, const void* m, size_t size, BaseType_t* woken)
+{
+  (void)size;
+  return xQueueSendFromISR(q, m, woken);
+}
+
+const OledLogger::msg_t* OledLogger::receive(msg_t& scratch, TickType_t wait)
+{
+  return (xQueueReceive(_queue, &scratch, wait) == pdTRUE) ? &scratch : nullptr;
+}
+
+void OledLogger::release(const msg_t* m)
+{
+  (void)m;
+}
+
+#endif
+
+size_t OledLogger::recordSize(const msg_t& m)
+{
+  size_t used;
+  if (m.kind == MSG_DUMP) {
+    used = m.len;
+  } else if (m.kind == MSG_CONST) {
+    used = sizeof(const OledConstLine*);
+  } else if (m.kind == MSG_CONTROL) {
+    used = (m.len == CTL_ARM)    ? sizeof(capture_t)
+         : (m.len == CTL_VIEW)   ? sizeof(view_t)
+         : (m.len == CTL_SCROLL) ? sizeof(int32_t)
+                                 : 0;
+  } else {
+    used = strnlen(m.txt, sizeof(m.txt) - 1) + 1;
+  }
+  return offsetof(msg_t, txt) + used;
+}
+
+void IRAM_ATTR OledLogger::sanitize(char* txt, size_t len)
 {
-  if (!_queue) return;
+  // Ensure string is printable ASCII only (strip control chars), keeping
+  // escape codes of icons that exist in the current table
+  for (size_t i = 0; i < len; ++i) {
+    unsigned char c = (unsigned char)txt[i];
+    if (c < 0x20) {
+      if (c == '\0') break;
+      if (c >= OLED_ICON_FIRST && c < OLED_ICON_FIRST + _iconCount) continue;
+      txt[i] = '?';
+    }
+  }
+}
 
+void OledLogger::vlogf(Level level, uint8_t tag, uint16_t fmt_id, const char* fmt, va_list ap)
+{
   msg_t m;
+  m.kind = MSG_TEXT;
+  m.level = level;
+  m.tag = tag;
+  m.fmt_id = fmt_id;
+  formatText(m.txt, sizeof(m.txt), fmt, ap);
+  sanitize(m.txt, sizeof(m.txt));
+#if OLED_LOGGER_PROFILE_SITES
+  profileSite(fmt, fmt_id, recordSize(m), !sendOrDropOldest(m));
+#else
+  sendOrDropOldest(m);
+#endif
+}
+
+bool OledLogger::formatText(char* buf, size_t cap, const char* fmt, va_list ap)
+{
+#if OLED_LOGGER_COMPACT_FORMAT
+  // only the stored length is known: a full buffer counts as clipped
+  return (size_t)OledFormat::vformat(buf, cap, fmt, ap) + 1 < cap;
+#else
+  return (size_t)vsnprintf(buf, cap, fmt, ap) < cap;
+#endif
+}
+
+void OledLogger::logf(const char* fmt, ...)
+{
+  if (!_queue || !enabled(LEVEL_INFO, 0)) return;
+
+  va_list ap;
+  va_start(ap, fmt);
+  vlogf(LEVEL_INFO, 0, 0, fmt, ap);
+  va_end(ap);
+}
+
+void OledLogger::logf(Level level, const char* fmt, ...)
+{
+  if (!_queue || !enabled(level, 0)) return;
+
   va_list ap;
   va_start(ap, fmt);
-  vsnprintf(m.txt, sizeof(m.txt), fmt, ap);
+  vlogf(level, 0, 0, fmt, ap);
   va_end(ap);
+}
 
-  // Ensure string is printable ASCII only (strip control chars)
-  for (size_t i = 0; i < sizeof(m.txt); ++i) {
-    if ((unsigned char)m.txt[i] < 0x20) {
-      if (m.txt[i] == '\0') break;
-      m.txt[i] = '?';
-    }
+void OledLogger::logf(Level level, uint8_t tag, const char* fmt, ...)
+{
+  if (!_queue || !enabled(level, tag)) return;
+
+  va_list ap;
+  va_start(ap, fmt);
+  vlogf(level, tag, 0, fmt, ap);
+  va_end(ap);
+}
+
+void OledLogger::logfId(Level level, uint8_t tag, uint16_t fmt_id, const char* fmt, ...)
+{
+  if (!_queue || !enabled(level, tag)) return;
+
+  va_list ap;
+  va_start(ap, fmt);
+  vlogf(level, tag, fmt_id, fmt, ap);
+  va_end(ap);
+}
+
+// --- multi-line blocks ---
+
+OledLogger::Block OledLogger::block(Level level, uint8_t tag)
+{
+  return Block(level, tag);
+}
+
+OledLogger::Block::Block(Level level, uint8_t tag)
+  : _txt(_m.txt), _cap(sizeof(_m.txt)), _used(0), _count(0), _live(_queue && enabled(level, tag))
+{
+  _m.kind = MSG_BLOCK;
+  _m.len = 0;
+  _m.level = level;
+  _m.tag = tag;
+  _m.fmt_id = 0;
+  _m.txt[0] = '\0';
+  // a screen of lines in a shared buffer, else what fits in the record
+  int slot = _live ? claimBlock() : -1;
+  if (slot >= 0) {
+    _m.len = (uint8_t)(slot + 1);
+    _txt = _blockText[slot];
+    _cap = BLOCK_TEXT;
   }
+  _txt[0] = '\0';
+}
 
-  sendOrDropOldest(m);
+OledLogger::Block::Block(Block&& other)
+  : _m(other._m), _cap(other._cap), _used(other._used), _count(other._count), _live(other._live)
+{
+  _txt = _m.len ? _blockText[_m.len - 1] : _m.txt;
+  other._live = false;
+  other._m.len = 0; // the slot moved here
 }
 
-BaseType_t OledLogger::logFromISR(const char* utf8msg)
+bool OledLogger::Block::line(const char* fmt, ...)
 {
-  if (!_queue) return pdFALSE;
-  msg_t m;
-  strncpy(m.txt, utf8msg, sizeof(m.txt) - 1);
-  m.txt[sizeof(m.txt) - 1] = '\0';
+  // a line after the first needs a separator and at least one character
+  const size_t start = _count ? _used + 1 : 0;
+  if (!_live || start >= _cap - 1) return false;
 
-  // sanitize control chars that may corrupt glyph rendering
-  for (size_t i = 0; i < sizeof(m.txt); ++i) {
-    if ((unsigned char)m.txt[i] < 0x20) {
-      if (m.txt[i] == '\0') break;
-      m.txt[i] = '?';
-    }
+  // each line also becomes a record of its own (history, display)
+  const size_t cap = std::min(_cap - start, sizeof(_m.txt));
+  va_list ap;
+  va_start(ap, fmt);
+  bool whole = formatText(_txt + start, cap, fmt, ap);
+  va_end(ap);
+  // sanitize first: a '\n' inside the line must not split it
+  sanitize(_txt + start, cap);
+  if (_count) _txt[_used] = '\n';
+  _used = start + strlen(_txt + start);
+  ++_count;
+  return whole;
+}
+
+void OledLogger::Block::send()
+{
+  if (!_live) return;
+  _live = false;
+  bool sent = false;
+  if (_count && _queue) {
+#if OLED_LOGGER_PROFILE_SITES
+    profileSite("(block)", 0, recordSize(_m), !sendOrDropOldest(_m, &sent));
+#else
+    sendOrDropOldest(_m, &sent);
+#endif
   }
+  // not queued: nobody else will free the slot
+  if (!sent) releaseBlock(_m);
+}
 
-  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-  BaseType_t res = xQueueSendFromISR(_queue, &m, &xHigherPriorityTaskWoken);
-  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
-  return res;
+int OledLogger::claimBlock()
+{
+  for (int i = 0; i < BLOCK_SLOTS; ++i) {
+    const uint32_t bit = 1u << i;
+    if (!(__atomic_fetch_or(&_blockBusy, bit, __ATOMIC_ACQ_REL) & bit)) return i;
+  }
+  return -1;
 }
 
-void OledLogger::taskFunc(void* pv)
+void OledLogger::releaseBlock(const msg_t& m)
 {
-  (void)pv;
-  if (!_display) {
-    vTaskDelete(nullptr);
-    return;
+  if (m.kind != MSG_BLOCK || !m.len) return;
+  __atomic_fetch_and(&_blockBusy, ~(1u << (m.len - 1)), __ATOMIC_ACQ_REL);
+}
+
+const char* OledLogger::blockText(const msg_t& m)
+{
+  return m.len ? _blockText[m.len - 1] : m.txt;
+}
+
+// --- filters ---
+
+void OledLogger::setMinLevel(Level level)
+{
+  _minLevel = level;
+}
+
+void OledLogger::setTagEnabled(uint8_t tag, bool on)
+{
+  uint32_t bit = 1u << (tag & 31);
+  if (on) __atomic_fetch_or((uint32_t*)&_tagMask[tag >> 5], bit, __ATOMIC_RELAXED);
+  else    __atomic_fetch_and((uint32_t*)&_tagMask[tag >> 5], ~bit, __ATOMIC_RELAXED);
+}
+
+void OledLogger::setRateLimit(uint16_t per_second)
+{
+  _rateLimit = per_second;
+}
+
+bool OledLogger::rateOk()
+{
+  // fixed one-second windows; two callers opening the same new window may
+  // both reset the count, which only lets a few extra messages through
+  uint32_t sec = millis() / 1000;
+  if (__atomic_load_n(&_rateSecond, __ATOMIC_RELAXED) != sec) {
+    __atomic_store_n(&_rateSecond, sec, __ATOMIC_RELAXED);
+    __atomic_store_n(&_rateCount, 0, __ATOMIC_RELAXED);
   }
+  if (__atomic_add_fetch(&_rateCount, 1, __ATOMIC_RELAXED) <= _rateLimit) return true;
+  __atomic_fetch_add(&_stats.rate_limited, 1, __ATOMIC_RELAXED);
+  return false;
+}
+
+// --- raw argument rendering for stripped-format builds (logId) ---
+
+// append printf output at pos, clipped to the record, returns the new end
+static size_t appendClipped(char* buf, size_t pos, size_t cap, const char* fmt, ...)
+{
+  if (pos >= cap - 1) return pos;
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf + pos, cap - pos, fmt, ap);
+  va_end(ap);
+  return std::min(pos + (size_t)std::max(n, 0), cap - 1);
+}
+
+size_t OledLogger::putArg(char* buf, size_t pos, long long v)
+{
+  return appendClipped(buf, pos, sizeof(msg_t::txt), " %lld", v);
+}
+
+size_t OledLogger::putArg(char* buf, size_t pos, unsigned long long v)
+{
+  return appendClipped(buf, pos, sizeof(msg_t::txt), " %llu", v);
+}
+
+size_t OledLogger::putArg(char* buf, size_t pos, double v)
+{
+  return appendClipped(buf, pos, sizeof(msg_t::txt), " %g", v);
+}
+
+size_t OledLogger::putArg(char* buf, size_t pos, const char* v)
+{
+  return appendClipped(buf, pos, sizeof(msg_t::txt), " %s", v ? v : "(null)");
+}
 
-  // TEXT_SIZE: keep explicit and deterministic
-  const int TEXT_SIZE = 1;               // must match begin() setting
-  const int LINE_HEIGHT = 8 * TEXT_SIZE; // 8 px per font line for textSize=1
+void OledLogger::logConst(Level level, const OledConstLine* line)
+{
+  if (!_queue || !line || !enabled(level, 0)) return;
 
-  // Maximum number of lines we can reasonably store in RAM (safe upper bound)
-  const int MAX_LINES = 16;
+  // only the pointer travels; the columns and text stay in flash
+  msg_t m;
+  m.kind = MSG_CONST;
+  m.level = level;
+  m.tag = 0;
+  m.fmt_id = 0;
+  memcpy(m.txt, &line, sizeof(line));
+#if OLED_LOGGER_PROFILE_SITES
+  profileSite(line->text, 0, recordSize(m), !sendOrDropOldest(m));
+#else
+  sendOrDropOldest(m);
+#endif
+}
 
-  // Compute how many lines fit on the display, clamp to MAX_LINES
-  int LINES = _height / LINE_HEIGHT;
-  LINES = std::max(1, std::min(LINES, MAX_LINES));
+void OledLogger::dump(const void* data, size_t len, Level level, uint8_t tag)
+{
+  if (!_queue || !data || !enabled(level, tag)) return;
 
-  // Circular buffer for lines: fixed-size array
-  static char lines[MAX_LINES][sizeof(msg_t::txt)];
-  // Initialize buffer (only once)
-  static bool initOnce = false;
-  if (!initOnce) {
-    for (int i = 0; i < MAX_LINES; ++i) lines[i][0] = '\0';
-    initOnce = true;
+  // raw bytes go out as-is, formatting happens in the render task
+  const uint8_t* p = (const uint8_t*)data;
+  for (size_t off = 0; off < len; off += sizeof(msg_t::txt)) {
+    msg_t m;
+    m.kind = MSG_DUMP;
+    m.level = level;
+    m.tag = tag;
+    m.fmt_id = 0;
+    m.offset = (uint16_t)off;
+    m.len = (uint8_t)std::min(len - off, sizeof(m.txt));
+    memcpy(m.txt, p + off, m.len);
+#if OLED_LOGGER_PROFILE_SITES
+    profileSite("(dump)", 0, recordSize(m), !sendOrDropOldest(m));
+#else
+    sendOrDropOldest(m);
+#endif
   }
+}
 
-  int writeIndex = -1; // newest message index (circular)
-  msg_t incoming;
+#if OLED_LOGGER_PROFILE_SITES
+// profiler key of ISR messages, in DRAM like the rest of the ISR path
+static DRAM_ATTR const char ISR_SITE[] = "(isr)";
+#endif
 
-  for (;;) {
-    if (xQueueReceive(_queue, &incoming, portMAX_DELAY) == pdTRUE) {
-      writeIndex = (writeIndex + 1) % LINES;
-      // copy safely
-      strncpy(lines[writeIndex], incoming.txt, sizeof(incoming.txt));
-      lines[writeIndex][sizeof(incoming.txt) - 1] = '\0';
+// The ISR path (this, sanitize, transportSendFromISR and the FreeRTOS
+// FromISR calls) is IRAM-resident and touches only DRAM data, so it also
+// works while the flash cache is disabled. No strncpy/strnlen/recordSize:
+// those may live in flash. tools/oled_iram_audit.py checks the built ELF.
+BaseType_t IRAM_ATTR OledLogger::logFromISR(const char* utf8msg)
+{
+  if (!_queue || !utf8msg) return pdFALSE;
+  // enabled(LEVEL_INFO, 0) spelled out: an inline call may land in flash
+  if (_minLevel > LEVEL_INFO || !(_tagMask[0] & 1u)) return pdFALSE;
+  msg_t m;
+  m.kind = MSG_TEXT;
+  m.level = LEVEL_INFO;
+  m.tag = 0;
+  m.fmt_id = 0;
+  size_t n = 0;
+  while (n < sizeof(m.txt) - 1 && utf8msg[n]) {
+    m.txt[n] = utf8msg[n];
+    ++n;
+  }
+  m.txt[n] = '\0';
+
+  // sanitize control chars that may corrupt glyph rendering
+  sanitize(m.txt, n);
 
-      // redraw display: oldest -> newest
-      _display->clearDisplay();
-      _display->setTextSize(TEXT_SIZE);
-      _display->setTextColor(SSD1306_WHITE);
+  const size_t size = offsetof(msg_t, txt) + n + 1;
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  BaseType_t res = transportSendFromISR(_queue, &m, size, &xHigherPriorityTaskWoken);
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+#if OLED_LOGGER_PROFILE_SITES
+  // an ISR cannot make room, a full transport loses this message instead
+  profileSite(ISR_SITE, 0, size, res != pdTRUE);
+#endif
+  return res;
+}
 
-      // Compute oldest index in circular buffer
-      int start = (writeIndex + 1) % LINES;
+void OledLogger::pushLine(const char* txt, uint8_t level, const OledConstLine* raster)
+{
+  _writeIndex = (_writeIndex + 1) % _numLines;
+  line_t& l = _lines[_writeIndex];
+  // copy safely
+  strncpy(l.txt, txt, sizeof(l.txt));
+  l.txt[sizeof(l.txt) - 1] = '\0';
+  l.raster = raster;
+  l.marked = false;
+  _linesChanged = true;
 
-      for (int i = 0; i < LINES; ++i) {
-        int idx = (start + i) % LINES;
+  // expiry is stamped once here; 0 is reserved for "never"
+  l.level = level;
+  l.expired = false;
+  l.expires = 0;
+  if (level < LEVEL_COUNT && _levelTtl[level]) {
+    l.expires = xTaskGetTickCount() + _levelTtl[level];
+    if (l.expires == 0) l.expires = 1;
+  }
+}
 
-        // CLEAR the line background before printing the new text to avoid leftover pixels
-        _display->fillRect(0, i * LINE_HEIGHT, _width, LINE_HEIGHT, SSD1306_BLACK);
+void OledLogger::pushDump(const msg_t& m)
+{
+  // "OOOO HHHHHHHH aaaa": 4-digit offset, then hex and ascii columns. Bytes
+  // per line follow the panel width (3 columns each plus 6 for the offset
+  // and gaps), rounded down to a power of two up to 8 so lines start at
+  // aligned offsets: 4 on a 128 px panel (21 columns).
+  const int cols = _width / OledFont::ADVANCE;
+  const int fit = std::max(1, std::min(8, (cols - 6) / 3));
+  int perLine = 1;
+  while (perLine * 2 <= fit) perLine *= 2;
 
-        // Ensure cursor at the start of the line and print (use print, not println)
-        _display->setCursor(0, i * LINE_HEIGHT);
-        _display->print(lines[idx]); // no println -> deterministic X/Y
-      }
+  for (int i = 0; i < m.len; i += perLine) {
+    char line[sizeof(_lines[0].txt)];
+    char* o = line;
+    unsigned off = m.offset + i;
+    *o++ = HEX_DIGITS[(off >> 12) & 0xF];
+    *o++ = HEX_DIGITS[(off >> 8) & 0xF];
+    *o++ = HEX_DIGITS[(off >> 4) & 0xF];
+    *o++ = HEX_DIGITS[off & 0xF];
+    *o++ = ' ';
+    int n = std::min(perLine, (int)m.len - i);
+    for (int j = 0; j < n; ++j) {
+      uint8_t b = (uint8_t)m.txt[i + j];
+      *o++ = HEX_DIGITS[b >> 4];
+      *o++ = HEX_DIGITS[b & 0xF];
+    }
+    // a short last line keeps the ascii column aligned
+    for (int j = n; j < perLine; ++j) { *o++ = ' '; *o++ = ' '; }
+    *o++ = ' ';
+    for (int j = 0; j < n; ++j) {
+      uint8_t b = (uint8_t)m.txt[i + j];
+      *o++ = (b >= 0x20 && b < 0x7F) ? (char)b : '.';
+    }
+    *o = '\0';
+    pushLine(line, m.level);
+  }
+}
 
-      // finally push to hardware once per frame (faster and avoids flicker)
-      _display->display();
+void OledLogger::setIcons(const OledIcon* icons, uint8_t count)
+{
+  if (!icons) {
+    icons = BUILTIN_ICONS;
+    count = sizeof(BUILTIN_ICONS) / sizeof(BUILTIN_ICONS[0]);
+  }
+  // shrink first so the renderer never indexes past the table being swapped in
+  _iconCount = 0;
+  _icons = icons;
+  _iconCount = std::min(count, (uint8_t)OLED_ICON_MAX);
+  // cached rows may hold old icons (benign race: the render task may still
+  // insert one row drawn with the previous table)
+  clearRasterCache();
+}
+
+void OledLogger::drawText(uint8_t* row, const char* txt)
+{
+  // row is pre-cleared
+  OledRaster::drawText(row, _width, txt, _icons, _iconCount);
+}
+
+int OledLogger::visibleLines(uint8_t* pages, uint8_t* idxs)
+{
+  const int numPages = _height / 8; // one page per line (5x7 font)
+
+  // text gets every page not owned by a widget; show the newest lines that fit
+  int textPages = 0;
+  for (int p = 0; p < numPages; ++p) {
+    if (!(_reservedPages & (1u << p))) ++textPages;
+  }
+  textPages = std::min(textPages, _numLines);
+
+  // oldest visible line in the circular buffer
+  int idx = (_writeIndex - textPages + 1 + _numLines) % _numLines;
+
+  int shown = 0;
+  for (int p = 0; p < numPages && shown < textPages; ++p) {
+    if (_reservedPages & (1u << p)) continue;
+    pages[shown] = (uint8_t)p;
+    idxs[shown] = (uint8_t)idx;
+    idx = (idx + 1) % _numLines;
+    ++shown;
+  }
+  return shown;
+}
+
+void OledLogger::drawLine(int idx, int page)
+{
+  uint8_t* row = _fb + page * _width;
+  const line_t& l = _lines[idx];
+
+  // CLEAR the line background before printing the new text to avoid leftover pixels
+  OledKernels::fill(row, 0, _width);
+
+  if (l.expired && _expiryMode == EXPIRE_BLANK) return;
+
+  if (l.raster) {
+    // constant line: rendered at compile time, just copy the row
+    OledKernels::copy(row, l.raster->cols, std::min((int)l.raster->width, _width));
+  } else {
+    // glyphs go straight into the page row, no GFX per-pixel drawing
+    drawTextCached(row, l.txt);
+  }
+
+  if (l.marked) {
+    OledKernels::invert(row, _width);
+  }
+
+  if (l.expired) {
+    // SSD1306 has no per-row brightness: dim with a checkerboard mask
+    OledKernels::maskAlternate(row, _width, 0x55, 0xAA);
+  }
+}
+
+uint16_t OledLogger::drawLines()
+{
+  uint8_t pages[MAX_LINES], idxs[MAX_LINES];
+  int n = visibleLines(pages, idxs);
+
+  // a page that comes out unchanged (repeated line, view or capture redraw)
+  // is not sent; the SSD1306 has at most 128 columns
+  uint8_t before[128];
+  const bool check = _width <= (int)sizeof(before);
+
+  uint16_t dirty = 0;
+  for (int i = 0; i < n; ++i) {
+    uint8_t* row = _fb + pages[i] * _width;
+    if (check) OledKernels::copy(before, row, _width);
+    drawLine(idxs[i], pages[i]);
+    if (!check || OledKernels::diff(before, row, _width, nullptr, nullptr)) {
+      dirty |= (uint16_t)(1u << pages[i]);
+    }
+  }
+  return dirty;
+}
+
+void OledLogger::clearRasterCache()
+{
+  for (size_t i = 0; i < _cacheSize; ++i) _cacheKeys[i].stamp = 0;
+}
+
+void OledLogger::drawTextCached(uint8_t* row, const char* txt)
+{
+  if (!_cacheSize) {
+    drawText(row, txt);
+    return;
+  }
+
+  uint16_t len;
+  uint32_t h = hashText(txt, &len);
+
+  size_t victim = 0;
+  for (size_t i = 0; i < _cacheSize; ++i) {
+    raster_key_t& k = _cacheKeys[i];
+    if (k.stamp && k.hash == h && k.len == len) {
+      k.stamp = ++_cacheClock;
+      OledKernels::copy(row, _cacheRows + i * _width, _width);
+      _stats.raster_cache_hits++;
+      return;
+    }
+    if (k.stamp < _cacheKeys[victim].stamp) victim = i; // empty slots (0) first
+  }
+
+  // miss: render and replace the least recently used row
+  drawText(row, txt);
+  _stats.raster_cache_misses++;
+  raster_key_t& k = _cacheKeys[victim];
+  k.hash = h;
+  k.len = len;
+  k.stamp = ++_cacheClock;
+  OledKernels::copy(_cacheRows + victim * _width, row, _width);
+}
+
+void OledLogger::renderLines()
+{
+  // a view is rebuilt from the index once per frame, not per record
+  if (_viewDirty && (_capState == CAP_LIVE || _capState == CAP_FROZEN)) showView();
+  // nothing new (e.g. capture armed): no redraw, no I2C
+  if (!_linesChanged) return;
+  _linesChanged = false;
+  _dirtyPages |= drawLines();
+}
+
+void OledLogger::flushDirty(bool onePage)
+{
+  if (!_dirtyPages) return;
+  if (!onePage) {
+    // push the text pages once per frame (faster and avoids flicker)
+    flushPages(_dirtyPages);
+    _dirtyPages = 0;
+    return;
+  }
+  uint16_t top = _dirtyPages & (uint16_t)(-_dirtyPages); // lowest set bit
+  flushPages(top);
+  _dirtyPages &= (uint16_t)~top;
+}
+
+void OledLogger::setLevelTtl(Level level, uint32_t ttl_ms)
+{
+  if (level >= LEVEL_COUNT) return;
+  _levelTtl[level] = ttl_ms ? std::max((TickType_t)1, (TickType_t)pdMS_TO_TICKS(ttl_ms)) : 0;
+}
+
+void OledLogger::setExpiryMode(ExpiryMode mode)
+{
+  _expiryMode = mode;
+}
+
+void OledLogger::expireLines()
+{
+  uint8_t pages[MAX_LINES], idxs[MAX_LINES];
+  int n = visibleLines(pages, idxs);
+  TickType_t now = xTaskGetTickCount();
+
+  for (int i = 0; i < n; ++i) {
+    line_t& l = _lines[idxs[i]];
+    if (l.expired || !l.expires) continue;
+    if ((int32_t)(now - l.expires) < 0) continue;
+    l.expired = true;
+    drawLine(idxs[i], pages[i]);
+    _dirtyPages |= (uint16_t)(1u << pages[i]);
+  }
+}
+
+TickType_t OledLogger::nextExpiry()
+{
+  // lines are stamped on arrival, so this is a scan of the visible lines only
+  uint8_t pages[MAX_LINES], idxs[MAX_LINES];
+  int n = visibleLines(pages, idxs);
+  TickType_t now = xTaskGetTickCount();
+  TickType_t wait = portMAX_DELAY;
+
+  for (int i = 0; i < n; ++i) {
+    const line_t& l = _lines[idxs[i]];
+    if (l.expired || !l.expires) continue;
+    int32_t left = (int32_t)(l.expires - now);
+    wait = std::min(wait, (TickType_t)std::max(left, (int32_t)0));
+  }
+  return wait;
+}
+
+int OledLogger::addWidget(WidgetKind kind, uint8_t page, uint16_t max_value)
+{
+  if (page >= _height / 8 || (_reservedPages & (1u << page))) return -1;
+  if (_numWidgets >= MAX_WIDGETS) return -1;
+
+  widget_t& w = _widgets[_numWidgets];
+  w.kind = kind;
+  w.page = page;
+  w.max_value = max_value ? max_value : 1;
+  w.value = 0;
+  w.drawn = NOT_DRAWN;
+  w.c0 = w.c1 = 0;
+  _reservedPages |= (uint16_t)(1u << page);
+  // publish after the entry is complete; the render task only reads [0, _numWidgets)
+  _numWidgets = _numWidgets + 1;
+  return _numWidgets - 1;
+}
+
+void IRAM_ATTR OledLogger::setWidget(int id, uint16_t value)
+{
+  if (id < 0 || id >= _numWidgets) return;
+  _widgets[id].value = value;
+}
+
+void OledLogger::renderWidgets()
+{
+  uint8_t* fb = _fb;
+
+  for (int i = 0; i < _numWidgets; ++i) {
+    widget_t& w = _widgets[i];
+    uint8_t* row = fb + w.page * _width;
+    uint16_t v = w.value; // single load of the producer's store
+    v = std::min(v, w.max_value);
+
+    if (w.kind == WIDGET_BAR) {
+      // columns 1..width-2 are the track; pos = number of filled columns
+      const int track = _width - 2;
+      uint16_t pos = (uint16_t)((uint32_t)v * track / w.max_value);
+      if (pos == w.drawn) continue;
+
+      if (w.drawn == NOT_DRAWN) {
+        row[0] = row[_width - 1] = WIDGET_BAR_END;
+        OledKernels::fill(row + 1, WIDGET_BAR_END, pos);
+        OledKernels::fill(row + 1 + pos, WIDGET_BAR_EMPTY, track - pos);
+        sendWidgetRange(w, 0, (uint8_t)_width);
+      } else {
+        // only the columns between old and new fill level change
+        uint16_t lo = std::min(pos, w.drawn), hi = std::max(pos, w.drawn);
+        OledKernels::fill(row + 1 + lo, (pos > w.drawn) ? WIDGET_BAR_END : WIDGET_BAR_EMPTY, hi - lo);
+        sendWidgetRange(w, (uint8_t)(1 + lo), (uint8_t)(1 + hi));
+      }
+      w.drawn = pos;
+    } else {
+      // needle position over the full width
+      const int travel = _width - WIDGET_GAUGE_NEEDLE_W;
+      uint16_t pos = (uint16_t)((uint32_t)v * travel / w.max_value);
+      if (pos == w.drawn) continue;
+
+      if (w.drawn == NOT_DRAWN) {
+        OledKernels::fill(row, WIDGET_GAUGE_AXIS, _width);
+        OledKernels::fill(row + pos, WIDGET_GAUGE_NEEDLE, WIDGET_GAUGE_NEEDLE_W);
+        sendWidgetRange(w, 0, (uint8_t)_width);
+      } else {
+        // erase old needle, draw new one; send two small ranges unless they overlap
+        OledKernels::fill(row + w.drawn, WIDGET_GAUGE_AXIS, WIDGET_GAUGE_NEEDLE_W);
+        OledKernels::fill(row + pos, WIDGET_GAUGE_NEEDLE, WIDGET_GAUGE_NEEDLE_W);
+        uint16_t lo = std::min(pos, w.drawn), hi = std::max(pos, w.drawn);
+        if (hi - lo <= WIDGET_GAUGE_NEEDLE_W * 2) {
+          sendWidgetRange(w, (uint8_t)lo, (uint8_t)(hi + WIDGET_GAUGE_NEEDLE_W));
+        } else {
+          sendWidgetRange(w, (uint8_t)w.drawn, (uint8_t)(w.drawn + WIDGET_GAUGE_NEEDLE_W));
+          sendWidgetRange(w, (uint8_t)pos, (uint8_t)(pos + WIDGET_GAUGE_NEEDLE_W));
+        }
+      }
+      w.drawn = pos;
+    }
+  }
+}
+
+void OledLogger::sendWidgetRange(widget_t& w, uint8_t c0, uint8_t c1)
+{
+  // render task: straight out. Polled mode: held until service() has
+  // budget for it, merged with what is still pending on the row.
+  if (_taskHandle) {
+    flushRange(w.page, c0, c1);
+    return;
+  }
+  if (w.c1 > w.c0) {
+    c0 = std::min(c0, w.c0);
+    c1 = std::max(c1, w.c1);
+  }
+  w.c0 = c0;
+  w.c1 = c1;
+}
+
+bool OledLogger::widgetsPending()
+{
+  for (int i = 0; i < _numWidgets; ++i) {
+    if (_widgets[i].c1 > _widgets[i].c0) return true;
+  }
+  return false;
+}
+
+bool OledLogger::flushWidgetStep()
+{
+  for (int i = 0; i < _numWidgets; ++i) {
+    widget_t& w = _widgets[i];
+    if (w.c1 <= w.c0) continue;
+    flushRange(w.page, w.c0, w.c1);
+    w.c0 = w.c1 = 0;
+    return true;
+  }
+  return false;
+}
+
+int OledLogger::reservePage(int page)
+{
+  const int pages = _height / 8;
+  if (page < 0) {
+    for (page = 0; page < pages && (_reservedPages & (1u << page)); ++page) {}
+  }
+  if (page >= pages || (_reservedPages & (1u << page))) return -1;
+  _reservedPages |= (uint16_t)(1u << page);
+  return page;
+}
+
+int OledLogger::addWatch(const char* label, const volatile void* ptr, uint8_t size,
+                         uint8_t kind, const char* format, int page)
+{
+  if (!ptr || !format || _numWatches >= MAX_WATCHES) return -1;
+  page = reservePage(page);
+  if (page < 0) return -1;
+
+  watch_t& w = _watches[_numWatches];
+  w.label = label ? label : "";
+  w.ptr = ptr;
+  w.format = format;
+  w.size = size;
+  w.kind = kind;
+  w.page = (uint8_t)page;
+  w.drawn = false;
+  w.last = 0;
+  // publish after the entry is complete; the render task only reads [0, _numWatches)
+  _numWatches = _numWatches + 1;
+  return _numWatches - 1;
+}
+
+// one load of the watched value, raw bits zero-extended
+static uint64_t sampleRaw(const volatile void* p, uint8_t size)
+{
+  switch (size) {
+    case 1:  return *(const volatile uint8_t*)p;
+    case 2:  return *(const volatile uint16_t*)p;
+    case 4:  return *(const volatile uint32_t*)p;
+    default: return *(const volatile uint64_t*)p; // may tear on 32-bit cores
+  }
+}
+
+void OledLogger::renderWatches()
+{
+  if (!_numWatches) return;
+  TickType_t now = xTaskGetTickCount();
+  if ((int32_t)(now - _nextWatch) < 0) return;
+  _nextWatch = now + pdMS_TO_TICKS(WATCH_FRAME_MS);
+
+  for (int i = 0; i < _numWatches; ++i) {
+    watch_t& w = _watches[i];
+    uint64_t raw = sampleRaw(w.ptr, w.size);
+    if (w.drawn && raw == w.last) continue;
+    w.last = raw;
+    w.drawn = true;
+
+    // reinterpret the raw bits as the watched type for the user format
+    char buf[sizeof(msg_t::txt)];
+    int n = snprintf(buf, sizeof(buf), "%s", w.label);
+    n = std::min(std::max(n, 0), (int)sizeof(buf) - 1);
+    char* out = buf + n;
+    size_t room = sizeof(buf) - n;
+    if (w.kind == WATCH_FLOAT) {
+      if (w.size == 4) {
+        uint32_t bits = (uint32_t)raw;
+        float f;
+        memcpy(&f, &bits, sizeof(f));
+        snprintf(out, room, w.format, (double)f);
+      } else {
+        double d;
+        memcpy(&d, &raw, sizeof(d));
+        snprintf(out, room, w.format, d);
+      }
+    } else if (w.kind == WATCH_SIGNED) {
+      // sign-extend from the value's width
+      int shift = 64 - 8 * w.size;
+      long long v = (long long)(raw << shift) >> shift;
+      if (w.size == 8) snprintf(out, room, w.format, v);
+      else             snprintf(out, room, w.format, (int)v);
+    } else {
+      if (w.size == 8) snprintf(out, room, w.format, (unsigned long long)raw);
+      else             snprintf(out, room, w.format, (unsigned)raw);
+    }
+    sanitize(buf, sizeof(buf));
+
+    uint8_t* row = _fb + w.page * _width;
+    OledKernels::fill(row, 0, _width);
+    drawTextCached(row, buf);
+    _dirtyPages |= (uint16_t)(1u << w.page);
+  }
+}
+
+// --- latency histograms ---
+
+// bucket of v: exact below 4, then 4 steps per power of two
+static inline IRAM_ATTR int histBucket(uint32_t v)
+{
+  if (v < 4) return (int)v;
+  int e = 31 - __builtin_clz(v);
+  return (e - 1) * 4 + (int)((v >> (e - 2)) & 3);
+}
+
+// smallest value falling into bucket b, and the bucket's width
+static inline uint32_t histLow(int b)
+{
+  if (b < 4) return (uint32_t)b;
+  int e = b / 4 + 1;
+  return (uint32_t)(4 | (b & 3)) << (e - 2);
+}
+
+static inline uint32_t histWidth(int b)
+{
+  return (b < 4) ? 1 : (uint32_t)1 << (b / 4 - 1);
+}
+
+int OledLogger::addHistogram(const char* label, int page, uint32_t divisor)
+{
+  if (_numHists >= MAX_HISTOGRAMS) return -1;
+
+  // internal RAM: sample() runs from ISRs, possibly with the cache off
+  uint32_t* counts = (uint32_t*)heap_caps_calloc(HIST_BUCKETS, sizeof(uint32_t),
+                                                 MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (!counts) {
+    Serial.println("OLED: histogram allocation failed");
+    return -1;
+  }
+  page = reservePage(page);
+  if (page < 0) {
+    free(counts);
+    return -1;
+  }
+
+  histogram_t& h = _hists[_numHists];
+  h.label = label ? label : "";
+  h.divisor = divisor ? divisor : 1;
+  h.page = (uint8_t)page;
+  h.counts = counts;
+  h.max = 0;
+  // publish after the entry is complete, as for watches
+  _numHists = _numHists + 1;
+  return _numHists - 1;
+}
+
+void IRAM_ATTR OledLogger::sample(int channel, uint32_t value)
+{
+  if ((unsigned)channel >= (unsigned)_numHists) return;
+  histogram_t& h = _hists[channel];
+  __atomic_fetch_add(&h.counts[histBucket(value)], 1, __ATOMIC_RELAXED);
+  // raise the window max; retries only when another sample raced us
+  uint32_t cur = __atomic_load_n(&h.max, __ATOMIC_RELAXED);
+  while (value > cur &&
+         !__atomic_compare_exchange_n(&h.max, &cur, value, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+void OledLogger::renderHistograms()
+{
+  if (!_numHists) return;
+  TickType_t now = xTaskGetTickCount();
+  if ((int32_t)(now - _nextHist) < 0) return;
+  _nextHist = now + pdMS_TO_TICKS(HIST_FRAME_MS);
+
+  for (int i = 0; i < _numHists; ++i) {
+    histogram_t& h = _hists[i];
+
+    // take the window bucket by bucket; samples landing mid-sweep count in
+    // this window or the next, none are lost
+    uint32_t counts[HIST_BUCKETS];
+    uint32_t n = 0;
+    for (int b = 0; b < HIST_BUCKETS; ++b) {
+      counts[b] = __atomic_exchange_n(&h.counts[b], 0, __ATOMIC_RELAXED);
+      n += counts[b];
+    }
+    uint32_t max = __atomic_exchange_n(&h.max, 0, __ATOMIC_RELAXED);
+    if (!n) continue; // idle window: keep the last figures on screen
+
+    // nearest-rank quantiles, reported as the bucket midpoint (never above max)
+    const uint32_t rank50 = (n + 1) / 2;
+    const uint32_t rank99 = n - n / 100;
+    uint32_t p50 = 0, p99 = 0, seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; ++b) {
+      if (!counts[b]) continue;
+      uint32_t mid = std::min(histLow(b) + histWidth(b) / 2, max);
+      if (seen < rank50 && seen + counts[b] >= rank50) p50 = mid;
+      seen += counts[b];
+      if (seen >= rank99) {
+        p99 = mid;
+        break;
+      }
+    }
+
+    char buf[sizeof(msg_t::txt)];
+    snprintf(buf, sizeof(buf), "%s%lu/%lu/%lu", h.label,
+             (unsigned long)(p50 / h.divisor), (unsigned long)(p99 / h.divisor),
+             (unsigned long)(max / h.divisor));
+    sanitize(buf, sizeof(buf));
+
+    uint8_t* row = _fb + h.page * _width;
+    OledKernels::fill(row, 0, _width);
+    drawText(row, buf);
+    _dirtyPages |= (uint16_t)(1u << h.page);
+  }
+}
+
+// --- system monitor ---
+
+int OledLogger::addMonitor(uint8_t rows, uint8_t max_overhead_pct)
+{
+  if (_monRows || rows < 1) return -1;
+  rows = (uint8_t)std::min((int)rows, (int)MONITOR_MAX_ROWS);
+
+  // all or nothing: check the free pages before claiming any
+  int avail = 0;
+  for (int p = 0; p < _height / 8; ++p) {
+    if (!(_reservedPages & (1u << p))) ++avail;
+  }
+  if (avail < rows) return -1;
+
+  for (int i = 0; i < rows; ++i) {
+    _monPages[i] = (uint8_t)reservePage(-1);
+    _monDrawn[i] = 0;
+  }
+  _monPct = max_overhead_pct ? max_overhead_pct : 1;
+  _monInterval = MONITOR_MIN_MS;
+  _nextMon = xTaskGetTickCount();
+  _monRows = rows;
+  return _monPages[0];
+}
+
+void OledLogger::monitorTasks(char (*text)[sizeof(msg_t::txt)], int rows)
+{
+#if OLED_MONITOR_TASK_STATS
+  // room for a few tasks created between the count and the snapshot
+  UBaseType_t want = uxTaskGetNumberOfTasks() + 4;
+  if (want > _monCap) {
+    TaskStatus_t* cur = (TaskStatus_t*)realloc(_monTasks, want * sizeof(TaskStatus_t));
+    if (cur) _monTasks = cur;
+    TaskStatus_t* prev = (TaskStatus_t*)realloc(_monPrev, want * sizeof(TaskStatus_t));
+    if (prev) _monPrev = prev;
+    if (!cur || !prev) return;
+    _monCap = want;
+  }
+
+  uint32_t total = 0;
+  UBaseType_t n = uxTaskGetSystemState(_monTasks, _monCap, &total);
+  // every core accumulates run time, so the window holds elapsed x cores
+  uint64_t window = (uint64_t)(uint32_t)(total - _monPrevTotal) * portNUM_PROCESSORS;
+
+  // top tasks by run time since the previous sample (since boot on the first)
+  const int slots = rows - 1;
+  int      topIdx[MONITOR_MAX_ROWS];
+  uint32_t topRun[MONITOR_MAX_ROWS];
+  int      found = 0;
+  for (UBaseType_t i = 0; i < n; ++i) {
+    uint32_t run = (uint32_t)_monTasks[i].ulRunTimeCounter;
+    for (UBaseType_t j = 0; j < _monPrevCount; ++j) {
+      if (_monPrev[j].xHandle == _monTasks[i].xHandle) {
+        run -= (uint32_t)_monPrev[j].ulRunTimeCounter;
+        break;
+      }
+    }
+    // insertion into the short sorted list
+    int k = std::min(found, slots);
+    while (k > 0 && topRun[k - 1] < run) {
+      if (k < slots) {
+        topIdx[k] = topIdx[k - 1];
+        topRun[k] = topRun[k - 1];
+      }
+      --k;
+    }
+    if (k < slots) {
+      topIdx[k] = (int)i;
+      topRun[k] = run;
+      if (found < slots) ++found;
+    }
+  }
+
+  for (int r = 0; r < found; ++r) {
+    unsigned pct = window ? (unsigned)((uint64_t)topRun[r] * 100 / window) : 0;
+    snprintf(text[1 + r], sizeof(text[0]), "%-10.10s %3u%%",
+             _monTasks[topIdx[r]].pcTaskName, pct);
+  }
+
+  // this sample becomes the baseline of the next
+  std::swap(_monTasks, _monPrev);
+  _monPrevCount = n;
+  _monPrevTotal = total;
+#else
+  (void)rows;
+  snprintf(text[1], sizeof(text[0]), "min %uk tasks %u",
+           (unsigned)(heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT) / 1024),
+           (unsigned)uxTaskGetNumberOfTasks());
+#endif
+}
+
+void OledLogger::renderMonitor()
+{
+  if (!_monRows) return;
+  TickType_t now = xTaskGetTickCount();
+  if ((int32_t)(now - _nextMon) < 0) return;
+
+  uint32_t start = micros();
+  char text[MONITOR_MAX_ROWS][sizeof(msg_t::txt)];
+  for (int i = 0; i < _monRows; ++i) text[i][0] = '\0';
+
+  // fragmentation shows as a largest block well below the free total
+  snprintf(text[0], sizeof(text[0]), "free %uk blk %uk",
+           (unsigned)(heap_caps_get_free_size(MALLOC_CAP_8BIT) / 1024),
+           (unsigned)(heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) / 1024));
+  if (_monRows > 1) monitorTasks(text, _monRows);
+
+  for (int i = 0; i < _monRows; ++i) drawRowIfChanged(_monPages[i], text[i], _monDrawn[i]);
+
+  // next sample: cost / interval stays under the overhead budget
+  uint32_t cost_us = micros() - start;
+  _monInterval = std::min((uint32_t)MONITOR_MAX_MS, std::max((uint32_t)MONITOR_MIN_MS, cost_us / (10u * _monPct)));
+  _nextMon = now + pdMS_TO_TICKS(_monInterval);
+}
+
+void OledLogger::drawRowIfChanged(uint8_t page, char* text, uint32_t& drawn)
+{
+  // only rows whose text changed are redrawn and flushed
+  sanitize(text, sizeof(msg_t::txt));
+  uint32_t h = hashText(text, nullptr) | 1; // never 0 (= not drawn)
+  if (h == drawn) return;
+  drawn = h;
+  uint8_t* row = _fb + page * _width;
+  OledKernels::fill(row, 0, _width);
+  drawText(row, text);
+  _dirtyPages |= (uint16_t)(1u << page);
+}
+
+// --- log-site profiler ---
+
+#if OLED_LOGGER_PROFILE_SITES
+// IRAM: also reached from logFromISR
+void IRAM_ATTR OledLogger::profileSite(const char* fmt, uint16_t fmt_id, size_t bytes, bool dropped)
+{
+  uintptr_t key = fmt ? (uintptr_t)fmt : (uintptr_t)fmt_id;
+  if (!key) return;
+
+  // linear probing; a free slot is claimed by CAS so concurrent first
+  // messages of one site agree on the slot. A full table stops tracking.
+  size_t i = (size_t)((key >> 2) * 2654435761u) % MAX_SITES;
+  for (int probe = 0; probe < MAX_SITES; ++probe, i = (i + 1) % MAX_SITES) {
+    site_t& s = _sites[i];
+    uintptr_t cur = __atomic_load_n(&s.key, __ATOMIC_ACQUIRE);
+    if (cur == 0) {
+      // the winner fills in the label; a report racing this sees "#0000"
+      uintptr_t expected = 0;
+      if (__atomic_compare_exchange_n(&s.key, &expected, key, false,
+                                      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        s.fmt = fmt;
+        s.fmt_id = fmt_id;
+        cur = key;
+      } else {
+        cur = expected;
+      }
+    }
+    if (cur != key) continue;
+    __atomic_fetch_add(&s.count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&s.bytes, (uint32_t)bytes, __ATOMIC_RELAXED);
+    if (dropped) __atomic_fetch_add(&s.drops, 1, __ATOMIC_RELAXED);
+    return;
+  }
+}
+#endif
+
+size_t OledLogger::topSites(SiteStats* out, size_t max, bool by_bytes)
+{
+#if OLED_LOGGER_PROFILE_SITES
+  if (!out) return 0;
+  size_t n = 0;
+  for (int i = 0; i < MAX_SITES; ++i) {
+    const site_t& s = _sites[i];
+    if (!__atomic_load_n(&s.key, __ATOMIC_ACQUIRE)) continue;
+    SiteStats e;
+    e.fmt = s.fmt;
+    e.fmt_id = s.fmt_id;
+    e.count = __atomic_load_n(&s.count, __ATOMIC_RELAXED);
+    e.bytes = __atomic_load_n(&s.bytes, __ATOMIC_RELAXED);
+    e.drops = __atomic_load_n(&s.drops, __ATOMIC_RELAXED);
+
+    // keep out[] sorted descending, the smallest falls off the end
+    uint32_t v = by_bytes ? e.bytes : e.count;
+    size_t k = std::min(n, max);
+    while (k > 0 && (by_bytes ? out[k - 1].bytes : out[k - 1].count) < v) {
+      if (k < max) out[k] = out[k - 1];
+      --k;
+    }
+    if (k < max) {
+      out[k] = e;
+      if (n < max) ++n;
+    }
+  }
+  return n;
+#else
+  (void)out;
+  (void)max;
+  (void)by_bytes;
+  return 0;
+#endif
+}
+
+int OledLogger::addTopTalkers(uint8_t rows)
+{
+#if OLED_LOGGER_PROFILE_SITES
+  if (_siteRows || rows < 1) return -1;
+  rows = (uint8_t)std::min((int)rows, (int)MONITOR_MAX_ROWS);
+
+  int avail = 0;
+  for (int p = 0; p < _height / 8; ++p) {
+    if (!(_reservedPages & (1u << p))) ++avail;
+  }
+  if (avail < rows) return -1;
+
+  for (int i = 0; i < rows; ++i) {
+    _sitePages[i] = (uint8_t)reservePage(-1);
+    _siteDrawn[i] = 0;
+  }
+  _nextSites = xTaskGetTickCount();
+  _siteRows = rows;
+  return _sitePages[0];
+#else
+  (void)rows;
+  return -1;
+#endif
+}
+
+void OledLogger::renderSites()
+{
+#if OLED_LOGGER_PROFILE_SITES
+  if (!_siteRows) return;
+  TickType_t now = xTaskGetTickCount();
+  if ((int32_t)(now - _nextSites) < 0) return;
+  _nextSites = now + pdMS_TO_TICKS(SITES_FRAME_MS);
+
+  SiteStats top[MONITOR_MAX_ROWS];
+  size_t n = topSites(top, _siteRows, false);
+  for (int i = 0; i < _siteRows; ++i) {
+    char text[sizeof(msg_t::txt)];
+    if ((size_t)i >= n) {
+      text[0] = '\0';
+    } else if (top[i].fmt) {
+      snprintf(text, sizeof(text), "%lu %s", (unsigned long)top[i].count, top[i].fmt);
+    } else {
+      snprintf(text, sizeof(text), "%lu #%04X", (unsigned long)top[i].count, (unsigned)top[i].fmt_id);
+    }
+    drawRowIfChanged(_sitePages[i], text, _siteDrawn[i]);
+  }
+#endif
+}
+
+TickType_t OledLogger::frameWait()
+{
+  TickType_t wait = portMAX_DELAY;
+  TickType_t now = xTaskGetTickCount();
+  if (_numWidgets) wait = pdMS_TO_TICKS(WIDGET_FRAME_MS);
+  if (_numWatches) {
+    int32_t left = (int32_t)(_nextWatch - now);
+    wait = std::min(wait, (TickType_t)std::max(left, (int32_t)0));
+  }
+  if (_numHists) {
+    int32_t left = (int32_t)(_nextHist - now);
+    wait = std::min(wait, (TickType_t)std::max(left, (int32_t)0));
+  }
+  if (_monRows) {
+    int32_t left = (int32_t)(_nextMon - now);
+    wait = std::min(wait, (TickType_t)std::max(left, (int32_t)0));
+  }
+#if OLED_LOGGER_PROFILE_SITES
+  if (_siteRows) {
+    int32_t left = (int32_t)(_nextSites - now);
+    wait = std::min(wait, (TickType_t)std::max(left, (int32_t)0));
+  }
+#endif
+  return wait;
+}
+
+bool OledLogger::endTransmission()
+{
+  uint8_t err = Wire.endTransmission();
+  _stats.i2c_transactions++;
+  if (err) _stats.i2c_errors++;
+  return err == 0;
+}
+
+bool OledLogger::sendCommands(const uint8_t* cmds, size_t n)
+{
+  Wire.beginTransmission(_i2c_addr);
+  Wire.write((uint8_t)OLED_CTRL_CMD);
+  Wire.write(cmds, n);
+  _stats.i2c_overhead_bytes += 2 + n; // address + control + commands
+  return endTransmission();
+}
+
+void OledLogger::flushRegion(uint8_t p0, uint8_t p1, uint8_t c0, uint8_t c1)
+{
+  if (c1 <= c0 || p1 < p0) return;
+
+  // Addressing and data share one transaction: each command byte rides on a
+  // Co=1 control byte, then a single data control byte starts the pixel stream.
+  const uint8_t hdr[] = {
+    OLED_CTRL_CMD_ONE, OLED_CMD_COLADDR,
+    OLED_CTRL_CMD_ONE, c0,
+    OLED_CTRL_CMD_ONE, (uint8_t)(c1 - 1),
+    OLED_CTRL_CMD_ONE, OLED_CMD_PAGEADDR,
+    OLED_CTRL_CMD_ONE, p0,
+    OLED_CTRL_CMD_ONE, p1,
+    OLED_CTRL_DATA
+  };
+
+  const uint8_t* fb = _fb;
+  const size_t rowLen = c1 - c0;
+
+  Wire.beginTransmission(_i2c_addr);
+  Wire.write(hdr, sizeof(hdr));
+  size_t inTx = sizeof(hdr);
+  _stats.i2c_overhead_bytes += 1 + sizeof(hdr);
+
+  // the window rows are not contiguous in the framebuffer unless full width;
+  // if the Wire buffer fills up, continue the data stream in a new transaction
+  for (int p = p0; p <= p1; ++p) {
+    const uint8_t* src = fb + p * _width + c0;
+    size_t left = rowLen;
+    while (left) {
+      if (inTx >= _wireMax) {
+        endTransmission();
+        Wire.beginTransmission(_i2c_addr);
+        Wire.write((uint8_t)OLED_CTRL_DATA);
+        inTx = 1;
+        _stats.i2c_overhead_bytes += 2;
+      }
+      size_t n = std::min(left, _wireMax - inTx);
+      Wire.write(src, n);
+      inTx += n;
+      src += n;
+      left -= n;
+      _stats.i2c_data_bytes += n;
+    }
+  }
+
+  endTransmission();
+}
+
+void OledLogger::flushRange(uint8_t page, uint8_t c0, uint8_t c1)
+{
+  flushRegion(page, page, c0, c1);
+}
+
+void OledLogger::flushPages(uint16_t mask)
+{
+  const int pages = _height / 8;
+  for (int p = 0; p < pages; ++p) {
+    if (!(mask & (1u << p))) continue;
+    int last = p;
+    while (last + 1 < pages && (mask & (1u << (last + 1)))) ++last;
+    flushRegion((uint8_t)p, (uint8_t)last, 0, (uint8_t)_width);
+    p = last;
+  }
+}
+
+void OledLogger::getStats(Stats& out)
+{
+  out = _stats;
+}
+
+void OledLogger::consume(const msg_t* m)
+{
+  if (m->kind == MSG_CONTROL) {
+    control(*m);
+    release(m);
+    __atomic_fetch_sub(&_ctlQueued, 1, __ATOMIC_ACQ_REL);
+    return;
+  }
+
+  // subscribers see every message, whatever the display is doing
+  if (_numSubs) notify(*m);
+
+  if (m->kind == MSG_BLOCK) {
+    // one record per line: every line lands in history and the ring before
+    // the next render, so the block shows up in one frame
+    msg_t line;
+    line.kind = MSG_TEXT;
+    line.len = 0;
+    line.level = m->level;
+    line.tag = m->tag;
+    line.offset = 0;
+    line.fmt_id = 0;
+    const char* p = blockText(*m);
+    for (;;) {
+      const char* nl = strchr(p, '\n');
+      size_t n = std::min(nl ? (size_t)(nl - p) : strlen(p), sizeof(line.txt) - 1);
+      memcpy(line.txt, p, n);
+      line.txt[n] = '\0';
+      consumeRecord(line);
+      if (!nl) break;
+      p = nl + 1;
+    }
+    releaseBlock(*m);
+  } else {
+    consumeRecord(*m);
+  }
+  release(m);
+}
+
+void OledLogger::consumeRecord(const msg_t& m)
+{
+  if (_capState == CAP_FROZEN) {
+    // keep the captured window intact until resume()
+    _stats.capture_discarded++;
+    return;
+  }
+  uint32_t seq = appendHistory(m);
+  if (_capState == CAP_LIVE) {
+    // a view following the newest records redraws from the index
+    if (!_view.level_mask) showRecord(m);
+    else if (_viewTop == NO_SEQ && viewMatch(seq)) _viewDirty = true;
+  } else if (_capState == CAP_ARMED) {
+    if (triggerMatch(m)) fire(seq);
+  } else if (--_capPostLeft == 0) {
+    _capState = CAP_FROZEN;
+    showHistory(_histSeq, _capTrigSeq);
+  }
+}
+
+void OledLogger::showRecord(const msg_t& m)
+{
+  if (m.kind == MSG_DUMP) {
+    pushDump(m);
+  } else if (m.kind == MSG_CONST) {
+    const OledConstLine* line;
+    memcpy(&line, m.txt, sizeof(line));
+    pushLine("", m.level, line);
+  } else {
+    pushLine(m.txt, m.level);
+  }
+}
+
+// --- subscribers ---
+
+int OledLogger::subscribe(Subscriber fn, void* ctx, uint8_t level_mask, int tag, uint32_t budget_us)
+{
+  if (!fn || _numSubs >= MAX_SUBSCRIBERS) return -1;
+
+  subscriber_t& s = _subs[_numSubs];
+  s.ctx = ctx;
+  s.level_mask = level_mask;
+  s.tag = (int16_t)((tag >= 0 && tag < 256) ? tag : -1);
+  s.budget_us = budget_us;
+  memset(&s.stats, 0, sizeof(s.stats));
+  s.fn = fn;
+  // publish after the entry is complete, as for watches
+  _numSubs = _numSubs + 1;
+  return _numSubs - 1;
+}
+
+void OledLogger::unsubscribe(int id)
+{
+  if (id < 0 || id >= _numSubs) return;
+  _subs[id].fn = nullptr;
+}
+
+bool OledLogger::getSubscriberStats(int id, SubscriberStats& out)
+{
+  if (id < 0 || id >= _numSubs) return false;
+  out = _subs[id].stats;
+  return true;
+}
+
+void OledLogger::notify(const msg_t& m)
+{
+  const char* text;
+  if (m.kind == MSG_CONST) {
+    const OledConstLine* line;
+    memcpy(&line, m.txt, sizeof(line));
+    text = line->text;
+  } else if (m.kind == MSG_TEXT) {
+    text = m.txt;
+  } else if (m.kind == MSG_BLOCK) {
+    text = blockText(m);
+  } else {
+    return; // dumps carry raw bytes
+  }
+
+  for (int i = 0; i < _numSubs; ++i) {
+    subscriber_t& s = _subs[i];
+    Subscriber fn = s.fn;
+    if (!fn) continue;
+    if (m.level >= LEVEL_COUNT || !(s.level_mask & (1u << m.level))) continue;
+    if (s.tag >= 0 && m.tag != (uint8_t)s.tag) continue;
+
+    uint32_t start = micros();
+    fn((Level)m.level, m.tag, text, s.ctx);
+    uint32_t took = micros() - start;
+
+    s.stats.calls++;
+    s.stats.total_us += took;
+    if (took > s.stats.max_us) s.stats.max_us = took;
+    if (s.budget_us && took > s.budget_us) s.stats.overruns++;
+  }
+}
+
+// --- history and capture mode ---
+
+bool OledLogger::setHistory(size_t records)
+{
+  if (_queue) return false; // the render task owns the ring once running
+
+  free(_hist);
+  free(_histLinks);
+  free(_levelBits);
+  free(_tagHead);
+  _hist = nullptr;
+  _histLinks = nullptr;
+  _levelBits = nullptr;
+  _tagHead = nullptr;
+  _histCap = 0;
+  _histSeq = 0;
+  if (!records) return true;
+
+  // records plus their index: 8 bytes of tag links and LEVEL_COUNT bits
+  // per slot, and the newest record of each tag
+  _histWords = (records + 31) / 32;
+  _hist = (msg_t*)malloc(records * sizeof(msg_t));
+  _histLinks = (hist_link_t*)malloc(records * sizeof(hist_link_t));
+  _levelBits = (uint32_t*)calloc(LEVEL_COUNT * _histWords, sizeof(uint32_t));
+  _tagHead = (uint32_t*)malloc(256 * sizeof(uint32_t));
+  if (!_hist || !_histLinks || !_levelBits || !_tagHead) {
+    Serial.println("OLED: history allocation failed");
+    setHistory(0);
+    return false;
+  }
+  for (int t = 0; t < 256; ++t) _tagHead[t] = NO_SEQ;
+  _histCap = records;
+  return true;
+}
+
+void OledLogger::requeueControl(const msg_t& m)
+{
+  // behind newer records now; if even that fails it is lost and no longer
+  // holds back the drop oldest policy
+  if (!sendWait(m, 0)) __atomic_fetch_sub(&_ctlQueued, 1, __ATOMIC_ACQ_REL);
+}
+
+bool OledLogger::sendControl(uint8_t op, const void* arg, size_t len)
+{
+  msg_t m;
+  m.kind = MSG_CONTROL;
+  m.len = op;
+  m.level = LEVEL_INFO;
+  m.tag = 0;
+  m.fmt_id = 0;
+  if (len) memcpy(m.txt, arg, len);
+
+  // counted before the send so the render task never sees it uncounted;
+  // log records stop evicting the oldest entry until it is consumed
+  __atomic_fetch_add(&_ctlQueued, 1, __ATOMIC_ACQ_REL);
+  if (sendWait(m, pdMS_TO_TICKS(CONTROL_WAIT_MS))) return true;
+  __atomic_fetch_sub(&_ctlQueued, 1, __ATOMIC_ACQ_REL);
+  return false;
+}
+
+bool OledLogger::capture(const Trigger& trig, uint16_t post_count)
+{
+  if (!_queue || !_hist) return false;
+
+  // applied by the render task in stream order, like any other record
+  capture_t c;
+  c.trig = trig;
+  c.post = post_count;
+  return sendControl(CTL_ARM, &c, sizeof(c));
+}
+
+bool OledLogger::trigger()
+{
+  return _queue && sendControl(CTL_TRIGGER, nullptr, 0);
+}
+
+BaseType_t IRAM_ATTR OledLogger::triggerFromISR()
+{
+  if (!_queue) return pdFALSE;
+  msg_t m;
+  m.kind = MSG_CONTROL;
+  m.len = CTL_TRIGGER;
+  m.level = LEVEL_INFO;
+  m.tag = 0;
+  m.fmt_id = 0;
+
+  // CTL_TRIGGER carries no payload; no recordSize() call from IRAM
+  __atomic_fetch_add(&_ctlQueued, 1, __ATOMIC_ACQ_REL);
+  BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+  BaseType_t res = transportSendFromISR(_queue, &m, offsetof(msg_t, txt), &xHigherPriorityTaskWoken);
+  if (res != pdTRUE) __atomic_fetch_sub(&_ctlQueued, 1, __ATOMIC_ACQ_REL);
+  portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+  return res;
+}
+
+bool OledLogger::resume()
+{
+  return _queue && sendControl(CTL_RESUME, nullptr, 0);
+}
+
+bool OledLogger::setView(uint8_t level_mask, int tag)
+{
+  if (!_queue || !_hist) return false;
+  view_t v;
+  v.level_mask = level_mask;
+  v.tag = (int16_t)((tag >= 0 && tag < 256) ? tag : -1);
+  return sendControl(CTL_VIEW, &v, sizeof(v));
+}
+
+bool OledLogger::scrollView(int lines)
+{
+  if (!_queue || !_hist || !lines) return false;
+  int32_t n = lines;
+  return sendControl(CTL_SCROLL, &n, sizeof(n));
+}
+
+void OledLogger::control(const msg_t& m)
+{
+  if (m.len == CTL_ARM) {
+    memcpy(&_cap, m.txt, sizeof(_cap));
+    _capState = CAP_ARMED;
+  } else if (m.len == CTL_TRIGGER) {
+    if (_capState != CAP_ARMED) return;
+    // the trigger point is recorded as a line of its own
+    msg_t mark;
+    mark.kind = MSG_TEXT;
+    mark.level = LEVEL_INFO;
+    mark.tag = 0;
+    mark.fmt_id = 0;
+    strcpy(mark.txt, "* trigger");
+    fire(appendHistory(mark));
+  } else if (m.len == CTL_RESUME) {
+    if (_capState == CAP_LIVE) return;
+    // back to live: the ring shows the newest history records (or view)
+    _capState = CAP_LIVE;
+    if (_view.level_mask) _viewDirty = true;
+    else                  showHistory(_histSeq, NO_SEQ);
+  } else if (m.len == CTL_VIEW) {
+    memcpy(&_view, m.txt, sizeof(_view));
+    _viewTop = NO_SEQ;
+    if (_view.level_mask) {
+      _viewDirty = true;
+    } else if (_capState == CAP_LIVE) {
+      _viewDirty = false;
+      showHistory(_histSeq, NO_SEQ);
+    }
+  } else if (m.len == CTL_SCROLL) {
+    if (!_view.level_mask) return;
+    int32_t n;
+    memcpy(&n, m.txt, sizeof(n));
+    uint32_t top = histValid(_viewTop) ? _viewTop : olderMatch(NO_SEQ);
+    if (top == NO_SEQ) return;
+    for (; n > 0; --n) {
+      uint32_t s = olderMatch(top);
+      if (s == NO_SEQ) break;
+      top = s;
+    }
+    for (; n < 0; ++n) {
+      top = newerMatch(top);
+      if (top == NO_SEQ) break; // back at the newest: follow
+    }
+    _viewTop = top;
+    _viewDirty = true;
+  }
+}
+
+uint32_t OledLogger::appendHistory(const msg_t& m)
+{
+  if (!_histCap) return _histSeq;
+  const uint32_t seq = _histSeq;
+  const size_t slot = seq % _histCap;
+
+  // O(1) index update: the overwritten record leaves the level bitmaps
+  // with its slot, links pointing at it turn stale by seq
+  const uint32_t bit = 1u << (slot & 31);
+  for (int l = 0; l < LEVEL_COUNT; ++l) _levelBits[l * _histWords + slot / 32] &= ~bit;
+  if (m.level < LEVEL_COUNT) _levelBits[m.level * _histWords + slot / 32] |= bit;
+
+  hist_link_t& link = _histLinks[slot];
+  link.prev_tag = _tagHead[m.tag];
+  link.next_tag = NO_SEQ;
+  if (link.prev_tag != NO_SEQ && seq - link.prev_tag < _histCap) {
+    _histLinks[link.prev_tag % _histCap].next_tag = seq;
+  }
+  _tagHead[m.tag] = seq;
+
+  // only the used bytes, the slot is a full msg_t
+  memcpy(&_hist[slot], &m, recordSize(m));
+  _histSeq = seq + 1;
+  return seq;
+}
+
+bool OledLogger::histValid(uint32_t seq)
+{
+  return seq != NO_SEQ && seq < _histSeq && _histSeq - seq <= _histCap;
+}
+
+bool OledLogger::viewMatch(uint32_t seq)
+{
+  const msg_t& m = _hist[seq % _histCap];
+  return (m.level < LEVEL_COUNT && (_view.level_mask & (1u << m.level))) &&
+         (_view.tag < 0 || m.tag == (uint8_t)_view.tag);
+}
+
+// bitmap word of slots [32 * word, 32 * word + 31) matching the view's levels
+static inline uint32_t levelWord(const uint32_t* bits, size_t words, uint8_t mask, size_t word)
+{
+  uint32_t w = 0;
+  for (int l = 0; l < OledLogger::LEVEL_COUNT; ++l) {
+    if (mask & (1u << l)) w |= bits[l * words + word];
+  }
+  return w;
+}
+
+uint32_t OledLogger::olderMatch(uint32_t seq)
+{
+  if (!_histSeq) return NO_SEQ;
+  const uint32_t oldest = (_histSeq > _histCap) ? _histSeq - (uint32_t)_histCap : 0;
+
+  if (_view.tag >= 0) {
+    // walk the tag chain, skipping records of other levels
+    uint32_t s = (seq == NO_SEQ) ? _tagHead[_view.tag] : _histLinks[seq % _histCap].prev_tag;
+    while (histValid(s) && !viewMatch(s)) s = _histLinks[s % _histCap].prev_tag;
+    return histValid(s) ? s : NO_SEQ;
+  }
+
+  // level bitmaps, newest first, skipping 32 records per empty word
+  if (seq == NO_SEQ) {
+    seq = _histSeq;
+  } else if (seq <= oldest) {
+    return NO_SEQ;
+  }
+  uint32_t s = seq - 1;
+  for (;;) {
+    const size_t slot = s % _histCap;
+    const unsigned b = slot & 31;
+    uint32_t w = levelWord(_levelBits, _histWords, _view.level_mask, slot / 32);
+    if (b < 31) w &= (2u << b) - 1; // slots up to this one
+    if (w) {
+      uint32_t hit = s - (b - (31 - __builtin_clz(w)));
+      return (hit >= oldest) ? hit : NO_SEQ;
+    }
+    if (s < oldest + b + 1) return NO_SEQ;
+    s -= b + 1; // last slot of the previous word (wraps with the ring)
+  }
+}
+
+uint32_t OledLogger::newerMatch(uint32_t seq)
+{
+  if (!histValid(seq)) return NO_SEQ;
+
+  if (_view.tag >= 0) {
+    uint32_t s = _histLinks[seq % _histCap].next_tag;
+    while (histValid(s) && !viewMatch(s)) s = _histLinks[s % _histCap].next_tag;
+    return histValid(s) ? s : NO_SEQ;
+  }
+
+  const uint32_t newest = _histSeq - 1;
+  uint32_t s = seq + 1;
+  while (s <= newest) {
+    const size_t slot = s % _histCap;
+    const unsigned b = slot & 31;
+    uint32_t w = levelWord(_levelBits, _histWords, _view.level_mask, slot / 32) & (~0u << b);
+    if (w) {
+      uint32_t hit = s + (__builtin_ctz(w) - b);
+      return (hit <= newest) ? hit : NO_SEQ;
+    }
+    // next word, or slot 0 when this word ends the ring
+    s += (uint32_t)std::min((size_t)(32 - b), _histCap - slot);
+  }
+  return NO_SEQ;
+}
+
+void OledLogger::showView()
+{
+  _viewDirty = false;
+  if (!_histCap) return;
+
+  uint8_t pages[MAX_LINES], idxs[MAX_LINES];
+  const int rows = visibleLines(pages, idxs);
+
+  // one index step per visible line, collected newest first
+  if (!histValid(_viewTop)) _viewTop = NO_SEQ;
+  uint32_t seqs[MAX_LINES];
+  int n = 0;
+  uint32_t s = (_viewTop != NO_SEQ) ? _viewTop : olderMatch(NO_SEQ);
+  while (n < rows && s != NO_SEQ) {
+    seqs[n++] = s;
+    s = olderMatch(s);
+  }
+
+  clearLines();
+  while (n > 0) showRecord(_hist[seqs[--n] % _histCap]);
+  _linesChanged = true;
+}
+
+void OledLogger::clearLines()
+{
+  for (int i = 0; i < MAX_LINES; ++i) {
+    _lines[i].txt[0] = '\0';
+    _lines[i].raster = nullptr;
+    _lines[i].expired = false;
+    _lines[i].marked = false;
+    _lines[i].expires = 0;
+  }
+  _writeIndex = -1;
+}
+
+bool OledLogger::triggerMatch(const msg_t& m)
+{
+  const Trigger& t = _cap.trig;
+  return (m.level >= t.min_level) ||
+         (t.tag >= 0 && m.tag == (uint8_t)t.tag) ||
+         (t.fmt_id && m.fmt_id == t.fmt_id);
+}
+
+void OledLogger::fire(uint32_t seq)
+{
+  _capTrigSeq = seq;
+  _capPostLeft = _cap.post;
+  _capState = CAP_POST;
+  if (_capPostLeft == 0) {
+    _capState = CAP_FROZEN;
+    showHistory(_histSeq, _capTrigSeq);
+  }
+}
+
+void OledLogger::showHistory(uint32_t end, uint32_t mark)
+{
+  if (!_histCap) return;
+
+  uint8_t pages[MAX_LINES], idxs[MAX_LINES];
+  const uint32_t rows = (uint32_t)visibleLines(pages, idxs);
+
+  // Keep the trigger on screen: at most half the rows after it, the rest
+  // before it. Records of several lines (dumps) push the oldest ones off.
+  if (mark != NO_SEQ && end - mark - 1 > rows / 2) end = mark + 1 + rows / 2;
+  uint32_t oldest = (_histSeq > _histCap) ? _histSeq - (uint32_t)_histCap : 0;
+  uint32_t start = (end - oldest > rows) ? end - rows : oldest;
+
+  clearLines();
+  for (uint32_t s = start; s < end; ++s) {
+    showRecord(_hist[s % _histCap]);
+    if (s == mark) _lines[_writeIndex].marked = true;
+  }
+  // a frozen window does not age out
+  for (int i = 0; i < MAX_LINES; ++i) _lines[i].expires = 0;
+  _linesChanged = true;
+}
+
+void OledLogger::service(uint32_t budget_us)
+{
+  if (_taskHandle || !_queue) return;
+
+  uint32_t start = micros();
+  msg_t scratch;
+
+  // the first frame goes out a page per step like any other update; the
+  // display comes on once all of it has been sent
+  if (_fb && !_started) {
+    if (!_framePending) startFrame(scratch);
+    do {
+      flushDirty(true);
+    } while (_dirtyPages && micros() - start < budget_us);
+    if (!_dirtyPages) displayOn();
+    return;
+  }
+
+  // drain what is queued (bounded by the budget, at least one record so a
+  // zero budget still makes progress), then draw once
+  bool got = false;
+  do {
+    const msg_t* m = receive(scratch, 0);
+    if (!m) break;
+    consume(m);
+    got = true;
+  } while (micros() - start < budget_us);
+  // headless: records only feed history and subscribers
+  if (!_fb) {
+    pollPanel();
+    return;
+  }
+  if (got) renderLines();
+  expireLines();
+  renderWatches();
+  renderHistograms();
+  renderMonitor();
+  renderSites();
+  renderWidgets();
+
+  // one page (or widget range) per step until the budget is used up
+  do {
+    if (!flushWidgetStep()) flushDirty(true);
+  } while ((_dirtyPages || widgetsPending()) && micros() - start < budget_us);
+}
+
+void OledLogger::taskFunc(void* pv)
+{
+  (void)pv;
+  msg_t scratch;
+
+  // headless: keep consuming (history, capture, subscribers) and sleep
+  // between probes until a panel answers
+  while (!_fb) {
+    TickType_t wait = portMAX_DELAY;
+    if (_probeInterval) {
+      int32_t left = (int32_t)(_nextProbe - xTaskGetTickCount());
+      wait = (TickType_t)std::max(left, (int32_t)0);
+    }
+    for (const msg_t* m = receive(scratch, wait); m; m = receive(scratch, 0)) consume(m);
+    pollPanel();
+  }
+
+  startFrame(scratch);
+  flushDirty(false);
+  displayOn();
+
+  for (;;) {
+    // widgets and watches are sampled at a fixed frame rate; otherwise sleep
+    // until a message arrives or the next line expires
+    TickType_t wait = std::min(frameWait(), nextExpiry());
+    const msg_t* incoming = receive(scratch, wait);
+    if (incoming) {
+      // take everything already queued so a burst costs one frame
+      do {
+        consume(incoming);
+      } while ((incoming = receive(scratch, 0)) != nullptr);
+      renderLines();
     }
+    expireLines();
+    renderWatches();
+    renderHistograms();
+    renderMonitor();
+    renderSites();
+    flushDirty(false);
+    renderWidgets();
   }
   // never returns
 }
@@ -2,16 +2,122 @@
 
 #include <Arduino.h>
 #include <Wire.h>
-#include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/queue.h>
 #include <stdarg.h>
+#include <stdio.h>
+#include <type_traits>
+#include "OledFmtId.h"
+#include "OledFont.h"
+#include "OledRaster.h"
+
+// Minimal builds: define to 1 to keep format strings out of flash. OLED_LOGF
+// then posts "#<id> <arg> <arg>..." and the host expands it with the
+// dictionary from tools/oled_fmt_dict.py.
+#ifndef OLED_LOGGER_STRIP_FORMATS
+#define OLED_LOGGER_STRIP_FORMATS 0
+#endif
+
+// Define to 1 to format logf records with the built-in printf subset of
+// OledFormat.h instead of newlib vsnprintf (faster, no reentrancy locks or
+// dtoa); see that header for the supported conversions.
+#ifndef OLED_LOGGER_COMPACT_FORMAT
+#define OLED_LOGGER_COMPACT_FORMAT 0
+#endif
+
+// Log-site profiler: define to 1 to count enqueues, bytes and overflow drops
+// per call site (format string pointer, or format id when stripped) for
+// topSites() and the top talkers page. Costs a table probe and three atomic
+// adds per message, so it is off by default.
+#ifndef OLED_LOGGER_PROFILE_SITES
+#define OLED_LOGGER_PROFILE_SITES 0
+#endif
+
+// Transport between producers and the render task:
+//  OLED_TRANSPORT_QUEUE   - FreeRTOS queue of fixed-size records (default)
+//  OLED_TRANSPORT_RINGBUF - ESP-IDF no-split ring buffer storing only the used
+//                           bytes of each record, received zero-copy
+// queue_len in begin() sizes both for that many full-length records (the ring
+// buffer adds its 8-byte item headers and holds at least two); the ring
+// buffer holds proportionally more short lines in the same RAM.
+#define OLED_TRANSPORT_QUEUE   0
+#define OLED_TRANSPORT_RINGBUF 1
+#ifndef OLED_LOGGER_TRANSPORT
+#define OLED_LOGGER_TRANSPORT OLED_TRANSPORT_QUEUE
+#endif
+#if OLED_LOGGER_TRANSPORT == OLED_TRANSPORT_RINGBUF
+#include <freertos/ringbuf.h>
+#endif
+
+// per-task CPU rows of the system monitor need FreeRTOS run-time stats
+#if configUSE_TRACE_FACILITY && configGENERATE_RUN_TIME_STATS
+#define OLED_MONITOR_TASK_STATS 1
+#else
+#define OLED_MONITOR_TASK_STATS 0
+#endif
+
+// printf style logging with a compile-time format id (fmt must be a literal)
+#if OLED_LOGGER_STRIP_FORMATS
+#define OLED_LOGT(level, tag, fmt, ...) OledLogger::logId(level, tag, OLED_FMT_ID(fmt), ##__VA_ARGS__)
+#else
+#define OLED_LOGT(level, tag, fmt, ...) OledLogger::logfId(level, tag, OLED_FMT_ID(fmt), fmt, ##__VA_ARGS__)
+#endif
+#define OLED_LOGL(level, fmt, ...) OLED_LOGT(level, 0, fmt, ##__VA_ARGS__)
+
+// filtered logging with lazy arguments: the argument expressions are only
+// evaluated when the level, tag and rate filters pass (see shouldLog()),
+// so expensive diagnostics can stay in hot code
+#define OLED_LOG(level, tag, fmt, ...) do { \
+    if (OledLogger::shouldLog(level, tag)) OLED_LOGT(level, tag, fmt, ##__VA_ARGS__); \
+  } while (0)
+
+// sampled logging for hot loops: OLED_LOG of every nth pass (n < 1 counts
+// as 1), or at most once per ms milliseconds; the first pass is always
+// logged. Per call site static state; a rejected pass costs one decrement
+// and compare (EVERY_N) or a flag test, a millis() read and compare
+// (EVERY_MS), arguments are not evaluated. The state is not atomic: sites
+// hit from several tasks may sample unevenly.
+#define OLED_LOG_EVERY_N(n, level, tag, fmt, ...) do { \
+    static uint32_t _oled_left = 0; \
+    if (_oled_left-- == 0) { \
+      _oled_left = ((n) > 1) ? (uint32_t)(n) - 1 : 0; \
+      OLED_LOG(level, tag, fmt, ##__VA_ARGS__); \
+    } \
+  } while (0)
+
+#define OLED_LOG_EVERY_MS(ms, level, tag, fmt, ...) do { \
+    static bool _oled_seen = false; \
+    static uint32_t _oled_last = 0; \
+    uint32_t _oled_now = millis(); \
+    if (!_oled_seen || _oled_now - _oled_last >= (uint32_t)(ms)) { \
+      _oled_seen = true; \
+      _oled_last = _oled_now; \
+      OLED_LOG(level, tag, fmt, ##__VA_ARGS__); \
+    } \
+  } while (0)
+#define OLED_LOGF(fmt, ...) OLED_LOGL(OledLogger::LEVEL_INFO, fmt, ##__VA_ARGS__)
+
+// constant line rasterized at compile time into flash; logging it enqueues a
+// pointer and rendering is a row copy (str must be a string literal)
+#define OLED_LOG_CONST(level, str) do { \
+    static constexpr auto _oled_raster = OledRaster::rasterize(str); \
+    static constexpr OledConstLine _oled_line = { _oled_raster.cols, sizeof(_oled_raster.cols), str }; \
+    OledLogger::logConst(level, &_oled_line); \
+  } while (0)
 
 class OledLogger {
 public:
   // Begin the logger. Call in setup().
   // sda_pin/scl_pin default to -1 (Wire.begin() default) if you set to -1.
+  // create_task = false selects polled mode: no render task (saves its 4 KB
+  // stack), the app calls service() from loop() instead.
+  // raster_cache_lines > 0 keeps that many rendered rows (width bytes each)
+  // in an LRU keyed by line text, so recurring lines skip the glyph path.
+  // If no panel answers at i2c_addr, begin() still succeeds in headless mode:
+  // no framebuffer or raster cache is allocated and nothing is drawn, but
+  // logging, history, capture and subscribers work as usual. The bus is
+  // probed periodically (see setPanelProbe) and a panel that shows up is
+  // initialised and drawn with the current lines.
   static bool begin(uint8_t i2c_addr = 0x3C,
                     int width = 128,
                     int height = 64,
@@ -19,33 +125,671 @@ public:
                     int scl_pin = -1,
                     size_t queue_len = 16,
                     UBaseType_t task_priority = 1,
-                    BaseType_t pinned_core = 1);
+                    BaseType_t pinned_core = 1,
+                    bool create_task = true,
+                    size_t raster_cache_lines = 0);
+
+  // polled mode: drain, render and flush within roughly budget_us. Pending
+  // pages and widget column ranges go out one per step, so a large update
+  // (the first frame included) may span several calls; at least one
+  // record is drained and one page or range sent per call, even with a
+  // zero budget. No-op when the render task runs.
+  static void service(uint32_t budget_us);
 
-  // printf style logging from tasks (non-blocking, drops oldest on overflow)
+  // message severity; logf without a level logs at LEVEL_INFO
+  enum Level : uint8_t { LEVEL_DEBUG = 0, LEVEL_INFO, LEVEL_WARN, LEVEL_ERROR, LEVEL_COUNT };
+
+  // printf style logging from tasks (non-blocking, drops oldest on overflow).
+  // tag is an app-defined subsystem number, 0 = untagged.
   static void logf(const char* fmt, ...);
+  static void logf(Level level, const char* fmt, ...);
+  static void logf(Level level, uint8_t tag, const char* fmt, ...);
+
+  // same as logf, tagging the record with an interned format id (see OLED_LOGF)
+  static void logfId(Level level, uint8_t tag, uint16_t fmt_id, const char* fmt, ...);
+
+  // stripped-format logging: renders the id and raw argument values only
+  template <typename... Args>
+  static void logId(Level level, uint8_t tag, uint16_t fmt_id, Args... args) {
+    if (!_queue || !enabled(level, tag)) return;
+    msg_t m;
+    m.kind = MSG_TEXT;
+    m.level = level;
+    m.tag = tag;
+    m.fmt_id = fmt_id;
+    size_t pos = (size_t)snprintf(m.txt, sizeof(m.txt), "#%04X", (unsigned)fmt_id);
+    putArgs(m.txt, pos, args...);
+    sanitize(m.txt, sizeof(m.txt));
+#if OLED_LOGGER_PROFILE_SITES
+    profileSite(nullptr, fmt_id, recordSize(m), !sendOrDropOldest(m));
+#else
+    sendOrDropOldest(m);
+#endif
+  }
+
+  // filters: messages below the minimum level or with a disabled tag are
+  // dropped before formatting (all tags enabled, LEVEL_DEBUG by default).
+  // This covers dump() and logFromISR() (LEVEL_INFO, tag 0) too; only the
+  // OLED_LOG macros apply the rate limit.
+  static void setMinLevel(Level level);
+  static void setTagEnabled(uint8_t tag, bool on);
+  // cap OLED_LOG sites at this many messages per second in total, 0 = off
+  static void setRateLimit(uint16_t per_second);
+
+  // level and tag filters; single loads, inline at every call site
+  static bool enabled(Level level, uint8_t tag) {
+    return level >= _minLevel && (_tagMask[tag >> 5] & (1u << (tag & 31)));
+  }
+  // enabled() plus the rate limit; a true result counts against the limit
+  static bool shouldLog(Level level, uint8_t tag) {
+    return enabled(level, tag) && (!_rateLimit || rateOk());
+  }
+
+  // multi-line block: lines added to the returned Block travel as one
+  // record (one enqueue, never interleaved with other tasks' messages) and
+  // are shown together in one frame. Sent when the Block goes out of scope
+  // or on send(). Lines are formatted straight into one of BLOCK_SLOTS
+  // shared buffers of BLOCK_TEXT bytes, a full 128x64 screen: 8 lines of
+  // 21 characters with their separators. Lines over 63 characters are
+  // clipped. While every buffer is taken by blocks not yet drawn, a block
+  // falls back to 63 characters in total, counting the separators.
+  //   OledLogger::Block b = OledLogger::block(OledLogger::LEVEL_ERROR);
+  //   b.line("PC %08x", pc);
+  //   b.line("SP %08x", sp);
+  class Block;
+  static Block block(Level level = LEVEL_INFO, uint8_t tag = 0);
+
+  // pre-rendered constant line, see OLED_LOG_CONST. line must stay valid forever.
+  static void logConst(Level level, const OledConstLine* line);
+
+  // hex dump of a binary buffer: one enqueue per 64 bytes, formatted as
+  // "offset hex ascii" lines by the render task, e.g. "0010 48454C4C HELL".
+  // A 128 px panel shows 4 bytes per line (8 from 180 px), so a 64-byte
+  // chunk is 16 lines there. Only the newest lines that fit stay on
+  // screen: with widgets or watches taking pages, or for dumps over one
+  // screen, the start scrolls off (it is kept in the history, if any).
+  static void dump(const void* data, size_t len, Level level = LEVEL_INFO, uint8_t tag = 0);
+
+  // progress bar / gauge widgets. Each owns one 8 px page (page 0 = top row);
+  // text lines use the remaining pages. Call from setup() after begin().
+  enum WidgetKind : uint8_t { WIDGET_BAR = 0, WIDGET_GAUGE = 1 };
+  // returns widget id, or -1 if the page is invalid/taken or the table is full
+  static int addWidget(WidgetKind kind, uint8_t page, uint16_t max_value = 100);
+  // single store, safe from any task or ISR; drawn at the next widget frame
+  static void setWidget(int id, uint16_t value);
+
+  // watch a variable: the render task samples it once per watch frame
+  // (~10 fps) and redraws "label<value>" on its own page only when the
+  // value changed. Producers pay nothing. format gets the value as int,
+  // unsigned, long long / unsigned long long (64-bit types) or double.
+  // page -1 takes the lowest free page. Returns watch id or -1.
+  template <typename T>
+  static int watch(const char* label, const volatile T* ptr, const char* format, int page = -1) {
+    static_assert(std::is_arithmetic<T>::value, "watch() needs an arithmetic type");
+    static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,
+                  "watch() supports 1, 2, 4 and 8 byte values");
+    return addWatch(label, (const volatile void*)ptr, sizeof(T),
+                    std::is_floating_point<T>::value ? WATCH_FLOAT
+                    : std::is_signed<T>::value       ? WATCH_SIGNED
+                                                     : WATCH_UNSIGNED,
+                    format, page);
+  }
 
-  // safe logging from ISR. returns pdTRUE if posted, pdFALSE if queue full.
+  // latency histograms: sample() records a value into a log-scale bucket
+  // histogram (one atomic increment plus a max update; lock-free, safe from
+  // any task or ISR). The render task shows "label<p50>/<p99>/<max>" of the
+  // last window (~2 per second) on the channel's page, values divided by
+  // divisor. page -1 takes the lowest free page. The buckets (~0.5 KB of
+  // internal RAM) are allocated here. Returns channel or -1.
+  static int addHistogram(const char* label, int page = -1, uint32_t divisor = 1);
+  static void sample(int channel, uint32_t value);
+
+  // times its scope in CPU cycles into a histogram channel; pass
+  // ESP.getCpuFreqMHz() as the channel divisor to show microseconds
+  class ScopedTimer {
+  public:
+    explicit ScopedTimer(int channel) : _channel(channel), _start(ESP.getCycleCount()) {}
+    ~ScopedTimer() { sample(_channel, ESP.getCycleCount() - _start); }
+  private:
+    ScopedTimer(const ScopedTimer&);
+    ScopedTimer& operator=(const ScopedTimer&);
+    int      _channel;
+    uint32_t _start;
+  };
+
+  // system monitor: rows pages (lowest free ones) showing free heap and the
+  // largest free block, then the tasks using the most CPU since the last
+  // sample (needs OLED_MONITOR_TASK_STATS, else minimum free heap and task
+  // count). The render task samples at most once per second, backing off
+  // (up to once every 10 s) so sampling stays under max_overhead_pct of its
+  // time. Returns the first
+  // page or -1 if the pages are not free or a monitor already exists.
+  static int addMonitor(uint8_t rows = 3, uint8_t max_overhead_pct = 1);
+
+  // replace the inline icon table (OLED_ICON_* codes index it from 0x10).
+  // The table is used in place, keep it in flash/static storage.
+  static void setIcons(const OledIcon* icons, uint8_t count);
+
+  // line aging: a line of this level blanks (or dims) ttl_ms after it is
+  // shown, so stale state does not stay on the panel. 0 = never (default).
+  enum ExpiryMode : uint8_t { EXPIRE_BLANK = 0, EXPIRE_DIM = 1 };
+  static void setLevelTtl(Level level, uint32_t ttl_ms);
+  static void setExpiryMode(ExpiryMode mode);
+
+  // safe logging from ISR at LEVEL_INFO, tag 0. returns pdTRUE if posted,
+  // pdFALSE if queue full or filtered out.
+  // IRAM-resident: also usable from IRAM ISRs while the flash cache is off
+  // (flash writes, OTA) if utf8msg is in RAM, e.g. DRAM_STR("...").
+  // triggerFromISR(), sample() and setWidget() are IRAM-resident as well.
   static BaseType_t logFromISR(const char* utf8msg);
 
-  // optional: check if initialized
+  // history: the render task keeps the last `records` messages (72 bytes
+  // each) for capture mode. Call before begin(); 0 disables.
+  static bool setHistory(size_t records);
+
+  // capture mode, like a logic analyzer: while armed, messages only go into
+  // history (no rendering, no I2C). The first message matching any enabled
+  // trigger condition, or a trigger() call, fires; post_count more messages
+  // are kept, then history freezes and the window around the trigger is
+  // shown with the trigger line inverted. resume() returns to live logging.
+  // Capture commands travel through the transport in stream order. They are
+  // never dropped to make room: a full transport waits up to CONTROL_WAIT_MS
+  // for space, and the calls return false if there was none (or no history).
+  struct Trigger {
+    uint8_t  min_level; // fire at this level or above, LEVEL_COUNT = off
+    int16_t  tag;       // fire on this tag, -1 = off
+    uint16_t fmt_id;    // fire on this interned format id, 0 = off
+
+    // every condition off: only trigger() fires
+    Trigger() : min_level(LEVEL_COUNT), tag(-1), fmt_id(0) {}
+    Trigger(uint8_t level, int16_t tag_ = -1, uint16_t fmt_id_ = 0)
+      : min_level(level), tag(tag_), fmt_id(fmt_id_) {}
+    static Trigger none() { return Trigger(); }
+  };
+  static bool capture(const Trigger& trig, uint16_t post_count);
+  // explicit trigger, marked in history as a "* trigger" line
+  static bool trigger();
+  // no wait from an ISR: pdFALSE if the transport is full
+  static BaseType_t triggerFromISR();
+  static bool resume();
+
+  // history browsing (needs setHistory): the text area shows only records
+  // whose level bit is set in level_mask (1 << Level) and, if tag >= 0,
+  // that carry the tag. Per-level slot bitmaps and per-tag record chains
+  // are kept with the ring, so a page costs O(visible lines) instead of a
+  // history scan. level_mask 0 returns to the live display.
+  static bool setView(uint8_t level_mask, int tag = -1);
+  // move the view by that many matching records (positive = older);
+  // scrolling back to the newest follows new matches again
+  static bool scrollView(int lines);
+
+  // log-site profile (OLED_LOGGER_PROFILE_SITES): the busiest call sites,
+  // sorted by message count (or bytes). drops counts the site's messages
+  // that found the transport full and pushed an older record out.
+  struct SiteStats {
+    const char* fmt;    // format string, nullptr for stripped formats
+    uint16_t    fmt_id; // interned format id, 0 if logged without one
+    uint32_t    count;
+    uint32_t    bytes;  // transport bytes
+    uint32_t    drops;
+  };
+  // fills up to max entries, returns how many; 0 when profiling is off
+  static size_t topSites(SiteStats* out, size_t max, bool by_bytes = false);
+  // top talkers page: rows pages of "<count> <format>", refreshed each
+  // second. Returns the first page, or -1 (pages taken, profiling off).
+  static int addTopTalkers(uint8_t rows = 3);
+
+  // subscribers: callbacks run by the render task (or service()) after a
+  // message is dequeued, so reacting to messages (blink on ERROR, count
+  // warnings) adds nothing to the producers. Called for text, block and
+  // constant lines whose level bit is in level_mask (1 << Level) and, if
+  // tag >= 0, that carry the tag; text is the record text (lines of a
+  // block separated by '\n'). Every call is timed; calls longer than
+  // budget_us (0 = no budget) count as overruns. Keep them short: they
+  // delay rendering. Returns subscriber id or -1 if the table is full.
+  typedef void (*Subscriber)(Level level, uint8_t tag, const char* text, void* ctx);
+  static int subscribe(Subscriber fn, void* ctx = nullptr, uint8_t level_mask = 0xF,
+                       int tag = -1, uint32_t budget_us = 0);
+  // stops further calls; the slot is not reused
+  static void unsubscribe(int id);
+  struct SubscriberStats {
+    uint32_t calls;
+    uint32_t total_us;
+    uint32_t max_us;
+    uint32_t overruns; // calls longer than budget_us
+  };
+  static bool getSubscriberStats(int id, SubscriberStats& out);
+
+  // runtime counters (render task side, read without locking)
+  struct Stats {
+    uint32_t i2c_transactions;   // START..STOP sequences sent to the panel
+    uint32_t i2c_data_bytes;     // framebuffer bytes sent
+    uint32_t i2c_overhead_bytes; // address, control and addressing command bytes
+    uint32_t i2c_errors;         // transactions not ACKed or timed out (the data is lost)
+    uint32_t startup_us;         // begin() to the first frame on the panel
+    uint32_t raster_cache_hits;  // text rows copied from the raster cache
+    uint32_t raster_cache_misses;
+    uint32_t capture_discarded;  // messages dropped while a capture is frozen
+    uint32_t rate_limited;       // OLED_LOG messages refused by the rate limit
+  };
+  static void getStats(Stats& out);
+
+  // optional: check if initialized (also true when headless)
   static bool isReady();
+  // no panel attached: messages are kept but not drawn
+  static bool isHeadless();
+  // headless probe period (default PROBE_MS); 0 stops looking for a panel
+  static void setPanelProbe(uint32_t interval_ms);
 
 private:
   // internal message structure
+  enum : uint8_t { MSG_TEXT = 0, MSG_DUMP = 1, MSG_CONST = 2, MSG_CONTROL = 3, MSG_BLOCK = 4 };
+
   struct msg_t {
+    uint8_t  kind;   // MSG_TEXT, MSG_DUMP, MSG_CONST (txt holds an OledConstLine*),
+                     // MSG_CONTROL (len = CTL_*, txt holds its argument)
+                     // or MSG_BLOCK ('\n'-separated lines in txt or a block
+                     // buffer, see _blockText)
+    uint8_t  len;    // MSG_DUMP: number of raw bytes in txt; MSG_BLOCK: slot + 1
+    uint8_t  level;  // Level
+    uint8_t  tag;    // app-defined subsystem, 0 = untagged
+    uint16_t offset; // MSG_DUMP: offset of txt[0] within the dumped buffer
+    uint16_t fmt_id; // interned format id, 0 if logged without one
     char txt[64]; // keep same size as your original; increase if you need longer lines
   };
 
+  struct widget_t {
+    uint8_t           kind;
+    uint8_t           page;
+    uint16_t          max_value;
+    volatile uint16_t value;
+    uint16_t          drawn;  // column position last drawn, NOT_DRAWN forces a full row
+    uint8_t           c0, c1; // polled mode: columns drawn but not sent (c1 <= c0: none)
+  };
+  static const uint16_t NOT_DRAWN = 0xFFFF;
+
+  enum : uint8_t { WATCH_SIGNED = 0, WATCH_UNSIGNED = 1, WATCH_FLOAT = 2 };
+  struct watch_t {
+    const char*          label;
+    const volatile void* ptr;
+    const char*          format;
+    uint8_t              size;  // bytes of the watched value
+    uint8_t              kind;  // WATCH_*
+    uint8_t              page;
+    bool                 drawn;
+    uint64_t             last;  // raw bits last drawn
+  };
+  static const int MAX_WATCHES = 4;
+  static const int WATCH_FRAME_MS = 100; // watch sampling period (10 fps)
+  static const int MAX_WIDGETS = 4;
+  static const int WIDGET_FRAME_MS = 10; // widget refresh period (100 Hz)
+
+  // log2 buckets split in 4 linear steps (~25% resolution); values 0..3 exact
+  static const int HIST_BUCKETS = 124;
+  struct histogram_t {
+    const char*       label;
+    uint32_t          divisor;
+    uint8_t           page;
+    uint32_t*         counts; // HIST_BUCKETS, this window, taken by the render task
+    uint32_t          max;                  // this window
+  };
+  static const int MAX_HISTOGRAMS = 4;
+  static const int HIST_FRAME_MS = 500; // histogram window / redraw period
+
+  static const int MONITOR_MAX_ROWS = 8;
+  static const int MAX_SUBSCRIBERS = 4;
+  static const uint32_t PROBE_MS = 1000;
+  static const int MAX_SITES = 64;        // profiled call sites (open addressing)
+  static const int SITES_FRAME_MS = 1000; // top talkers refresh period
+  static const uint32_t MONITOR_MIN_MS = 1000;  // sampling interval bounds
+  static const uint32_t MONITOR_MAX_MS = 10000;
+
+  // filter state, read by producers without locking
+  static volatile uint8_t  _minLevel;
+  static volatile uint32_t _tagMask[8];   // bit per tag
+  static volatile uint16_t _rateLimit;    // per second, 0 = off
+  static uint32_t          _rateSecond;   // millis() / 1000 of the current window
+  static uint32_t          _rateCount;    // messages let through in it
+  static bool rateOk();
+
   static TaskHandle_t    _taskHandle;
+#if OLED_LOGGER_TRANSPORT == OLED_TRANSPORT_RINGBUF
+  static RingbufHandle_t _queue;
+  static volatile bool   _held;      // a received record is not returned yet
+#else
   static QueueHandle_t   _queue;
-  static Adafruit_SSD1306* _display;
+#endif
+  static uint8_t*       _fb;        // width x pages, page-major (SSD1306 RAM layout)
+  static uint32_t       _beginUs;
+  static bool           _started;    // first frame sent
+  static bool           _framePending; // first frame drawn, pages still going out
+  static size_t         _cacheWant;  // raster_cache_lines, allocated with the panel
+  static TickType_t     _probeInterval; // headless probe period, 0 = off
+  static TickType_t     _nextProbe;
+  static uint16_t       _dirtyPages; // drawn but not yet flushed
   static int            _width;
   static int            _height;
   static uint8_t        _i2c_addr;
   static size_t         _queue_len;
+  static size_t         _wireMax;   // bytes one Wire transaction can carry (buffer and timeout)
+  static Stats          _stats;
+
+  // on-screen line ring (owned by the render task)
+  struct line_t {
+    char       txt[sizeof(msg_t::txt)];
+    const OledConstLine* raster; // pre-rendered row, replaces txt when set
+    uint8_t    level;
+    bool       expired;
+    bool       marked;  // capture trigger line, drawn inverted
+    TickType_t expires; // tick the line ages out at, 0 = never
+  };
+  static const int MAX_LINES = 16;
+  static line_t         _lines[MAX_LINES];
+  static int            _numLines;
+  static int            _writeIndex;
+  static bool           _linesChanged; // ring changed since the last render
+
+  static TickType_t     _levelTtl[LEVEL_COUNT]; // in ticks, 0 = no ttl
+  static ExpiryMode     _expiryMode;
+
+  static widget_t       _widgets[MAX_WIDGETS];
+  static volatile int   _numWidgets;
+  static uint16_t       _reservedPages; // bit per page owned by a widget, watch or histogram
+
+  static watch_t        _watches[MAX_WATCHES];
+  static volatile int   _numWatches;
+  static TickType_t     _nextWatch;     // tick of the next watch sample
+
+  static histogram_t    _hists[MAX_HISTOGRAMS];
+  static volatile int   _numHists;
+  static TickType_t     _nextHist;      // tick the current window closes
+
+  static uint8_t        _monPages[MONITOR_MAX_ROWS];
+  static uint32_t       _monDrawn[MONITOR_MAX_ROWS]; // text hash per row, 0 = not drawn
+  static volatile int   _monRows;
+  static uint8_t        _monPct;        // overhead budget, percent of render task time
+  static uint32_t       _monInterval;   // ms, adapted to the measured cost
+  static TickType_t     _nextMon;
+
+  struct subscriber_t {
+    Subscriber volatile fn; // nullptr once unsubscribed
+    void*           ctx;
+    uint8_t         level_mask;
+    int16_t         tag;
+    uint32_t        budget_us;
+    SubscriberStats stats;  // updated by the render task
+  };
+  static subscriber_t   _subs[MAX_SUBSCRIBERS];
+  static volatile int   _numSubs;
+
+#if OLED_LOGGER_PROFILE_SITES
+  // one profiled call site; key claimed once by CAS, counters atomic adds
+  struct site_t {
+    uintptr_t   key;    // format pointer or fmt_id, 0 = free slot
+    const char* fmt;
+    uint16_t    fmt_id;
+    uint32_t    count;
+    uint32_t    bytes;
+    uint32_t    drops;
+  };
+  static site_t         _sites[MAX_SITES];
+  static uint8_t        _sitePages[MONITOR_MAX_ROWS];
+  static uint32_t       _siteDrawn[MONITOR_MAX_ROWS];
+  static volatile int   _siteRows;
+  static TickType_t     _nextSites;
+#endif
+#if OLED_MONITOR_TASK_STATS
+  // last sample, kept for run-time counter deltas
+  static TaskStatus_t*  _monTasks;
+  static TaskStatus_t*  _monPrev;
+  static UBaseType_t    _monCap;
+  static UBaseType_t    _monPrevCount;
+  static uint32_t       _monPrevTotal;
+#endif
+
+  // raster cache: rows of rendered text keyed by hash + length, LRU by stamp
+  struct raster_key_t {
+    uint32_t hash;
+    uint16_t len;
+    uint32_t stamp; // last use, 0 = empty slot
+  };
+  static uint8_t*       _cacheRows;
+  static raster_key_t*  _cacheKeys;
+  static size_t         _cacheSize;
+  static uint32_t       _cacheClock;
+
+  static const OledIcon* _icons;
+  static uint8_t        _iconCount;
+
+  // history ring and capture state (owned by the render task)
+  enum : uint8_t { CTL_ARM = 0, CTL_TRIGGER = 1, CTL_RESUME = 2, CTL_VIEW = 3, CTL_SCROLL = 4 };
+  enum : uint8_t { CAP_LIVE = 0, CAP_ARMED, CAP_POST, CAP_FROZEN };
+  struct capture_t {
+    Trigger  trig;
+    uint16_t post;
+  };
+  static const uint32_t CONTROL_WAIT_MS = 100;
+  // control records in the transport; while any are queued, a full
+  // transport drops the new log record instead of the oldest
+  static volatile uint32_t _ctlQueued;
+
+  // block text buffers: MSG_BLOCK records with len = slot + 1 carry their
+  // text in _blockText[slot] (len 0: in txt). A slot is taken by Block and
+  // freed once its record is consumed or dropped.
+  static const size_t BLOCK_TEXT = 8 * 22;
+  static const int BLOCK_SLOTS = 2;
+  static char              _blockText[BLOCK_SLOTS][BLOCK_TEXT];
+  static volatile uint32_t _blockBusy; // bit per slot
+  static int claimBlock();
+  static void releaseBlock(const msg_t& m);
+  static const char* blockText(const msg_t& m);
+  static const uint32_t NO_SEQ = 0xFFFFFFFFu;
+  struct view_t {
+    uint8_t  level_mask; // 0 = view off
+    int16_t  tag;        // -1 = any
+  };
+  // tag chain links of a history slot, as record seqs (NO_SEQ = none);
+  // links to evicted records are recognised by their seq
+  struct hist_link_t {
+    uint32_t prev_tag;
+    uint32_t next_tag;
+  };
+  static msg_t*         _hist;
+  static size_t         _histCap;
+  static uint32_t       _histSeq;     // records ever appended; slot = seq % cap
+  static hist_link_t*   _histLinks;   // per slot
+  static uint32_t*      _levelBits;   // LEVEL_COUNT bitmaps of _histWords words, bit per slot
+  static size_t         _histWords;
+  static uint32_t*      _tagHead;     // newest seq per tag (256)
+  static view_t         _view;
+  static uint32_t       _viewTop;     // newest record shown, NO_SEQ = follow new ones
+  static bool           _viewDirty;
+  static uint8_t        _capState;
+  static capture_t      _cap;
+  static uint32_t       _capTrigSeq;  // history seq of the trigger record
+  static uint16_t       _capPostLeft;
 
   static void taskFunc(void* pv);
 
-  // helper to safely send a message (non-ISR)
-  static void sendOrDropOldest(const msg_t &m);
+  // route a received record (history, capture, ring lines) and release it
+  static void consume(const msg_t* m);
+  // history, capture and ring lines for one record (one line of a block)
+  static void consumeRecord(const msg_t& m);
+  // turn a log record into ring lines
+  static void showRecord(const msg_t& m);
+  // run the subscribers interested in m, timing each call
+  static void notify(const msg_t& m);
+  // capture control records and state transitions
+  static void control(const msg_t& m);
+  static uint32_t appendHistory(const msg_t& m);
+  // seq is still in the ring
+  static bool histValid(uint32_t seq);
+  static bool viewMatch(uint32_t seq);
+  // newest view match older than seq (NO_SEQ: newest overall), oldest
+  // match newer than seq; NO_SEQ if none
+  static uint32_t olderMatch(uint32_t seq);
+  static uint32_t newerMatch(uint32_t seq);
+  // refill the ring with the view page ending at _viewTop
+  static void showView();
+  static void clearLines();
+  static bool triggerMatch(const msg_t& m);
+  static void fire(uint32_t seq);
+  // refill the ring with history records before seq `end`, inverting `mark`
+  static void showHistory(uint32_t end, uint32_t mark);
+  // send a control record, waiting up to CONTROL_WAIT_MS for room
+  static bool sendControl(uint8_t op, const void* arg, size_t len);
+  // put back a control record taken out to make room (uncounted if lost)
+  static void requeueControl(const msg_t& m);
+  // append one line to the ring (no redraw)
+  static void pushLine(const char* txt, uint8_t level, const OledConstLine* raster = nullptr);
+  // format a MSG_DUMP record into hex/ascii lines
+  static void pushDump(const msg_t& m);
+  // blit text (glyphs and icon codes) into one page row of the framebuffer
+  static void drawText(uint8_t* row, const char* txt);
+  // drawText through the raster cache
+  static void drawTextCached(uint8_t* row, const char* txt);
+  static void clearRasterCache();
+  // pages and ring indexes of the visible lines, top to bottom; returns count
+  static int visibleLines(uint8_t* pages, uint8_t* idxs);
+  // redraw one line into its page (honouring expiry); caller flushes
+  static void drawLine(int idx, int page);
+  // redraw all lines oldest -> newest; returns the pages drawn
+  static uint16_t drawLines();
+  // drawLines() into the dirty set, if the ring changed
+  static void renderLines();
+  // age out lines whose ttl passed, marking only their pages dirty
+  static void expireLines();
+  // ticks until the next visible line expires, portMAX_DELAY if none
+  static TickType_t nextExpiry();
+  // draw changed widgets into their pages and send only the changed columns
+  static void renderWidgets();
+  // widget columns to send: immediately from the render task, else queued
+  static void sendWidgetRange(widget_t& w, uint8_t c0, uint8_t c1);
+  static bool widgetsPending();
+  // polled mode: send one pending widget range, false if there was none
+  static bool flushWidgetStep();
+
+  // claim a page for a widget/watch/histogram: page, or the lowest free one
+  // if -1. Returns the page or -1 if it is invalid or taken.
+  static int reservePage(int page);
+  static int addWatch(const char* label, const volatile void* ptr, uint8_t size,
+                      uint8_t kind, const char* format, int page);
+  // sample watches when their frame is due, redrawing changed ones (dirty set)
+  static void renderWatches();
+  // close the histogram window when due: quantiles onto each channel's page
+  static void renderHistograms();
+  // sample heap/tasks when due and redraw the monitor rows that changed
+  static void renderMonitor();
+  // fill text[1..rows) with the top tasks by CPU since the last sample
+  static void monitorTasks(char (*text)[sizeof(msg_t::txt)], int rows);
+  // refresh the top talkers rows when due
+  static void renderSites();
+  // draw text into a reserved page unless it matches the hash last drawn there
+  static void drawRowIfChanged(uint8_t page, char* text, uint32_t& drawn);
+  // how long the render task may sleep before widgets/watches need a frame
+  static TickType_t frameWait();
+
+  // direct panel access: command list, and framebuffer regions sent as one
+  // transaction (addressing commands + data) when the Wire buffer and
+  // timeout allow
+  static bool sendCommands(const uint8_t* cmds, size_t n);
+  // end a Wire transaction, counting it (and a failure) in the stats
+  static bool endTransmission();
+  // panel init sequence (display left off)
+  static bool panelInit();
+  // drain startup records into the first frame and mark every page dirty
+  static void startFrame(msg_t& scratch);
+  // first frame sent: display on, startup time recorded
+  static void displayOn();
+  // headless: address-only write to see if a panel ACKs
+  static bool probePanel();
+  // allocate the framebuffer (and raster cache) and bring the panel up
+  static bool attachPanel();
+  // probe when due and attach a panel that answers
+  static void pollPanel();
+  // flush dirty pages: all (coalesced) or only the topmost one
+  static void flushDirty(bool onePage);
+  static void flushRegion(uint8_t p0, uint8_t p1, uint8_t c0, uint8_t c1);
+  static void flushRange(uint8_t page, uint8_t c0, uint8_t c1);
+  // full-width flush of the pages in mask, runs of adjacent pages coalesced
+  static void flushPages(uint16_t mask);
+
+  // transport primitives (queue or ring buffer, see OLED_LOGGER_TRANSPORT)
+  static bool createTransport();
+  static void deleteTransport();
+  // bytes of m that carry data: header plus used part of txt
+  static size_t recordSize(const msg_t& m);
+  // next record, or nullptr on timeout; may point into the transport's storage
+  // (zero-copy) until release(). scratch backs the copying queue transport.
+  static const msg_t* receive(msg_t& scratch, TickType_t wait);
+  static void release(const msg_t* m);
+
+  // helper to safely send a message (non-ISR); false if older records
+  // had to be dropped to make room, or m itself when the oldest is (or
+  // may be) a control record or dropping would not free the room. sent
+  // (optional) tells whether m went in.
+  static bool sendOrDropOldest(const msg_t &m, bool* sent = nullptr);
+  // blocking send for control records, false on timeout
+  static bool sendWait(const msg_t &m, TickType_t wait);
+
+#if OLED_LOGGER_PROFILE_SITES
+  // attribute one message to its call site
+  static void profileSite(const char* fmt, uint16_t fmt_id, size_t bytes, bool dropped);
+#endif
+
+  static void vlogf(Level level, uint8_t tag, uint16_t fmt_id, const char* fmt, va_list ap);
+  // record text formatting: vsnprintf, or OledFormat with OLED_LOGGER_COMPACT_FORMAT.
+  // false if the text was clipped (OledFormat: or exactly filled buf)
+  static bool formatText(char* buf, size_t cap, const char* fmt, va_list ap);
+
+  // replace control chars that would corrupt glyph rendering
+  static void sanitize(char* txt, size_t len);
+
+  // raw argument rendering for logId(): " <value>" appended at pos, clipped
+  static size_t putArg(char* buf, size_t pos, long long v);
+  static size_t putArg(char* buf, size_t pos, unsigned long long v);
+  static size_t putArg(char* buf, size_t pos, double v);
+  static size_t putArg(char* buf, size_t pos, const char* v);
+
+  template <typename T>
+  static size_t putArgT(char* buf, size_t pos, T v) {
+    typedef typename std::conditional<std::is_floating_point<T>::value, double,
+            typename std::conditional<std::is_signed<T>::value, long long,
+                                      unsigned long long>::type>::type arg_t;
+    return putArg(buf, pos, (arg_t)v);
+  }
+  static size_t putArgT(char* buf, size_t pos, const char* v) { return putArg(buf, pos, v); }
+  static size_t putArgT(char* buf, size_t pos, char* v) { return putArg(buf, pos, (const char*)v); }
+
+  static size_t putArgs(char* buf, size_t pos) { (void)buf; return pos; }
+  template <typename T, typename... Rest>
+  static size_t putArgs(char* buf, size_t pos, T v, Rest... rest) {
+    return putArgs(buf, putArgT(buf, pos, v), rest...);
+  }
+};
+
+class OledLogger::Block {
+public:
+  Block(Block&& other);
+  ~Block() { send(); }
+
+  // append one printf-formatted line; false if it was clipped (to 63
+  // characters or the room left) or not added: block full or sent
+  bool line(const char* fmt, ...);
+  // enqueue the collected lines now; later line() calls are ignored
+  void send();
+
+private:
+  friend class OledLogger;
+  Block(Level level, uint8_t tag);
+  Block(const Block&);
+  Block& operator=(const Block&);
+
+  msg_t  _m;     // _m.len: block slot + 1, 0 = text in _m.txt
+  char*  _txt;   // the slot's buffer or _m.txt
+  size_t _cap;   // bytes of _txt
+  size_t _used;  // bytes of _txt holding lines and separators
+  int    _count; // lines added
+  bool   _live;  // not sent yet, and passed the level/tag filter
 };
+
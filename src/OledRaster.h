@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "OledFont.h"
+
+// Rasterization of log lines into one page row (8 px high, a byte per column).
+//
+// OledRaster::drawText() is the line renderer the logger uses at runtime.
+// OledRaster::rasterize("BOOT OK") evaluates at compile time to the column
+// bytes drawText() would draw for that text (same OledFont table, 6 columns
+// per character), so OLED_LOG_CONST can enqueue a pointer to flash and the
+// render task copies the row instead of drawing glyphs. Icon codes are not
+// expanded there (the icon table is swappable at runtime) and render as '?'.
+
+// one constant line: pre-rendered columns plus the source text
+struct OledConstLine {
+  const uint8_t* cols;
+  uint16_t       width; // columns in cols
+  const char*    text;
+};
+
+namespace OledRaster {
+
+// draw txt into a pre-cleared row of width columns, clipped at the right
+// edge; codes from OLED_ICON_FIRST draw icons[code - OLED_ICON_FIRST] when
+// below iconCount. Glyphs and icons are plain column copies.
+inline void drawText(uint8_t* row, int width, const char* txt, const OledIcon* icons, unsigned iconCount)
+{
+  int x = 0;
+  for (const char* c = txt; *c && x < width; ++c) {
+    unsigned char ch = (unsigned char)*c;
+    unsigned icon = ch - OLED_ICON_FIRST;
+    if (icon < iconCount) {
+      const OledIcon& ic = icons[icon];
+      int n = (ic.width < width - x) ? ic.width : width - x;
+      memcpy(row + x, ic.cols, n);
+      x += n;
+      continue;
+    }
+    const uint8_t* g = OledFont::glyph((char)ch);
+    int n = (OledFont::GLYPH_W < width - x) ? OledFont::GLYPH_W : width - x;
+    memcpy(row + x, g, n);
+    x += OledFont::ADVANCE;
+  }
+}
+
+// C++11 has no std::index_sequence
+template <size_t... I> struct index_seq {};
+template <size_t N, size_t... I> struct make_index_seq : make_index_seq<N - 1, N - 1, I...> {};
+template <size_t... I> struct make_index_seq<0, I...> { typedef index_seq<I...> type; };
+
+template <size_t W>
+struct Raster {
+  uint8_t cols[W];
+};
+
+// column x of the rendered string: glyph column, or the blank advance column
+constexpr uint8_t column(const char* s, size_t x) {
+  return (x % OledFont::ADVANCE < (size_t)OledFont::GLYPH_W)
+           ? OledFont::glyph(s[x / OledFont::ADVANCE])[x % OledFont::ADVANCE]
+           : (uint8_t)0;
+}
+
+template <size_t N, size_t... I>
+constexpr Raster<sizeof...(I)> rasterize(const char (&s)[N], index_seq<I...>) {
+  return Raster<sizeof...(I)>{ { column(s, I)... } };
+}
+
+// N counts the terminating NUL
+template <size_t N>
+constexpr Raster<(N - 1) * OledFont::ADVANCE> rasterize(const char (&s)[N]) {
+  static_assert(N > 1, "OLED_LOG_CONST needs a non-empty string literal");
+  return rasterize(s, typename make_index_seq<(N - 1) * OledFont::ADVANCE>::type());
+}
+
+} // namespace OledRaster
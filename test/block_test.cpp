@@ -0,0 +1,170 @@
+// OledLogger::Block on the host models (queue transport): a screen of lines
+// in one record, line() reporting clipping, and block buffers always freed,
+// whether the record is consumed, dropped or never sent.
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Arduino.h"
+#include "Wire.h"
+// history and the block buffers are private
+#define private public
+#include "OledLogger.h"
+#undef private
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const char* what, ...)
+{
+  if (ok) return;
+  ++failures;
+  va_list ap;
+  va_start(ap, what);
+  printf("FAIL ");
+  vprintf(what, ap);
+  printf("\n");
+  va_end(ap);
+}
+
+const size_t QUEUE_LEN = 4;
+
+std::vector<std::string> seen;
+
+void record(OledLogger::Level level, uint8_t tag, const char* text, void* ctx)
+{
+  (void)level; (void)tag; (void)ctx;
+  seen.push_back(text);
+}
+
+void drain()
+{
+  seen.clear();
+  while (uxQueueMessagesWaiting(OledLogger::_queue)) OledLogger::service(100000);
+}
+
+// the newest n history records, oldest first
+std::vector<std::string> history(size_t n)
+{
+  std::vector<std::string> out;
+  for (uint32_t seq = OledLogger::_histSeq - n; seq != OledLogger::_histSeq; ++seq) {
+    out.push_back(OledLogger::_hist[seq % OledLogger::_histCap].txt);
+  }
+  return out;
+}
+
+std::string row(int i)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "R%02d 0123456789abcdefg", i); // 21 characters
+  return buf;
+}
+
+// a 128x64 screen: 8 lines of 21 characters in one record, one history
+// record per line
+void fullScreen()
+{
+  {
+    OledLogger::Block b = OledLogger::block(OledLogger::LEVEL_ERROR, 7);
+    for (int i = 0; i < 8; ++i) expect(b.line("%s", row(i).c_str()), "line %d reported clipped", i);
+    expect(!b.line("more"), "a ninth line fit");
+  }
+  expect(uxQueueMessagesWaiting(OledLogger::_queue) == 1, "block is not one record");
+  drain();
+  std::string all;
+  for (int i = 0; i < 8; ++i) all += (i ? "\n" : "") + row(i);
+  expect(seen.size() == 1 && seen[0] == all, "subscriber did not get the block once");
+  std::vector<std::string> h = history(8);
+  for (int i = 0; i < 8; ++i) expect(h[i] == row(i), "history line %d: '%s'", i, h[i].c_str());
+  const OledLogger::msg_t& last = OledLogger::_hist[(OledLogger::_histSeq - 1) % OledLogger::_histCap];
+  expect(last.kind == OledLogger::MSG_TEXT && last.level == OledLogger::LEVEL_ERROR && last.tag == 7,
+         "history line record");
+  expect(OledLogger::_blockBusy == 0, "buffer not freed after consume");
+}
+
+// a line is clipped at 63 characters, and reported
+void longLine()
+{
+  {
+    OledLogger::Block b = OledLogger::block();
+    expect(!b.line("%s", std::string(80, 'x').c_str()), "80 characters not reported clipped");
+    expect(b.line("short"), "line after a clipped one");
+  }
+  drain();
+  expect(seen.size() == 1 && seen[0] == std::string(63, 'x') + "\nshort", "clipped block text");
+}
+
+// every buffer taken: the next block falls back to the record's 63 bytes
+void buffersTaken()
+{
+  OledLogger::Block a = OledLogger::block();
+  OledLogger::Block b = OledLogger::block();
+  a.line("a");
+  b.line("b");
+  {
+    OledLogger::Block c = OledLogger::block();
+    expect(c.line("%s", row(0).c_str()) && c.line("%s", row(1).c_str()), "fallback: first lines");
+    expect(!c.line("%s", row(2).c_str()), "fallback: third line not reported clipped");
+  }
+  a.send();
+  b.send();
+  drain();
+  expect(seen.size() == 3 && seen[0] == row(0) + "\n" + row(1) + "\n" + row(2).substr(0, 19),
+         "fallback block text");
+  expect(OledLogger::_blockBusy == 0, "buffers not freed");
+}
+
+// a block record dropped by the drop oldest policy, or not sent at all,
+// gives its buffer back
+void buffersFreed()
+{
+  {
+    OledLogger::Block b = OledLogger::block();
+    b.line("dropped");
+  }
+  for (size_t i = 0; i < QUEUE_LEN; ++i) OledLogger::logf("line %zu", i);
+  expect(OledLogger::_blockBusy == 0, "evicted block kept its buffer");
+
+  __atomic_store_n(&OledLogger::_ctlQueued, 1, __ATOMIC_RELEASE);
+  {
+    OledLogger::Block b = OledLogger::block();
+    b.line("refused");
+  }
+  __atomic_store_n(&OledLogger::_ctlQueued, 0, __ATOMIC_RELEASE);
+  expect(OledLogger::_blockBusy == 0, "refused block kept its buffer");
+
+  { OledLogger::Block empty = OledLogger::block(); }
+  OledLogger::setMinLevel(OledLogger::LEVEL_WARN);
+  { OledLogger::Block filtered = OledLogger::block(OledLogger::LEVEL_INFO); }
+  OledLogger::setMinLevel(OledLogger::LEVEL_DEBUG);
+  expect(OledLogger::_blockBusy == 0, "unsent block kept its buffer");
+  drain();
+}
+
+} // namespace
+
+int main()
+{
+  // headless polled logger: records only reach history and subscribers
+  OledLogger::setHistory(32);
+  Wire.devices.clear();
+  bool ok = OledLogger::begin(0x3C, 128, 64, -1, -1, QUEUE_LEN, 1, 1, false);
+  expect(ok && OledLogger::isHeadless(), "headless begin failed");
+  OledLogger::setPanelProbe(0);
+  OledLogger::subscribe(record);
+
+  fullScreen();
+  longLine();
+  buffersTaken();
+  buffersFreed();
+
+  if (failures) {
+    printf("block_test: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("block_test: ok\n");
+  return 0;
+}
@@ -0,0 +1,114 @@
+// OledLogger::dump() line layout by panel width: "OOOO HHHHHHHH aaaa",
+// 4 bytes per line on a 128 px panel, 8 from 180 px, the ascii column
+// aligned on a short last line. dump() and logFromISR() obey the level and
+// tag filters.
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Arduino.h"
+#include "Wire.h"
+// the line ring is private
+#define private public
+#include "OledLogger.h"
+#undef private
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const char* what, ...)
+{
+  if (ok) return;
+  ++failures;
+  va_list ap;
+  va_start(ap, what);
+  printf("FAIL ");
+  vprintf(what, ap);
+  printf("\n");
+  va_end(ap);
+}
+
+// dump data on a headless logger of the given width; the newest n lines
+std::vector<std::string> dumpLines(int width, const void* data, size_t len, int n)
+{
+  Wire.reset();
+  Wire.devices.clear();
+  bool ok = OledLogger::begin(0x3C, width, 64, -1, -1, 16, 1, 1, false);
+  expect(ok, "begin failed");
+  OledLogger::setPanelProbe(0);
+  OledLogger::dump(data, len);
+  while (uxQueueMessagesWaiting(OledLogger::_queue)) OledLogger::service(100000);
+
+  std::vector<std::string> out;
+  for (int k = n - 1; k >= 0; --k) {
+    int idx = (OledLogger::_writeIndex - k + OledLogger::_numLines) % OledLogger::_numLines;
+    out.push_back(OledLogger::_lines[idx].txt);
+  }
+  return out;
+}
+
+void check(int width, const std::vector<std::string>& got, const std::vector<std::string>& want)
+{
+  for (size_t i = 0; i < want.size(); ++i) {
+    expect(got[i] == want[i], "%d px line %zu: '%s', want '%s'", width, i, got[i].c_str(), want[i].c_str());
+  }
+}
+
+UBaseType_t queued() { return uxQueueMessagesWaiting(OledLogger::_queue); }
+
+void filters()
+{
+  const char data[4] = {};
+  OledLogger::setMinLevel(OledLogger::LEVEL_WARN);
+  OledLogger::dump(data, sizeof(data));
+  expect(queued() == 0, "dump below the minimum level queued");
+  expect(OledLogger::logFromISR("isr") == pdFALSE && queued() == 0, "ISR message below the minimum level queued");
+  OledLogger::dump(data, sizeof(data), OledLogger::LEVEL_ERROR);
+  expect(queued() == 1, "error dump not queued");
+  OledLogger::setMinLevel(OledLogger::LEVEL_DEBUG);
+
+  OledLogger::setTagEnabled(5, false);
+  OledLogger::dump(data, sizeof(data), OledLogger::LEVEL_INFO, 5);
+  expect(queued() == 1, "dump with a disabled tag queued");
+  OledLogger::setTagEnabled(0, false);
+  expect(OledLogger::logFromISR("isr") == pdFALSE && queued() == 1, "ISR message with tag 0 disabled queued");
+  OledLogger::setTagEnabled(0, true);
+  OledLogger::setTagEnabled(5, true);
+  expect(OledLogger::logFromISR("isr") == pdTRUE && queued() == 2, "ISR message not queued");
+}
+
+} // namespace
+
+int main()
+{
+  const char data[] = "HELLO\x01\x7f\xff" "0";
+
+  check(128, dumpLines(128, data, 9, 3), {
+    "0000 48454C4C HELL",
+    "0004 4F017FFF O...",
+    "0008 30       0",
+  });
+  check(192, dumpLines(192, data, 9, 2), {
+    "0000 48454C4C4F017FFF HELLO...",
+    "0008 30               0",
+  });
+  // every line fits the panel's columns
+  for (int width = 64; width <= 256; width += 6) {
+    std::vector<std::string> lines = dumpLines(width, data, 9, 1);
+    int cols = width / 6;
+    expect((int)lines[0].size() <= cols, "%d px: '%s' wider than %d columns", width,
+           lines[0].c_str(), cols);
+  }
+
+  filters();
+
+  if (failures) {
+    printf("dump_test: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("dump_test: ok\n");
+  return 0;
+}
@@ -0,0 +1,39 @@
+// Host benchmark: OledFormat::format against snprintf on typical log lines.
+// Absolute numbers are the host's; the ratio is what carries over.
+#include "OledFormat.h"
+#include <chrono>
+#include <stdio.h>
+
+namespace {
+
+const int ITERATIONS = 1000000;
+volatile int sink;
+
+template <typename F>
+double nsPerCall(F f)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < ITERATIONS; ++i) f(i);
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / ITERATIONS;
+}
+
+} // namespace
+
+#define BENCH(name, fmt, ...) \
+  do { \
+    char buf[64]; \
+    double lib = nsPerCall([&](int i) { (void)i; sink = snprintf(buf, sizeof(buf), fmt, __VA_ARGS__); }); \
+    double own = nsPerCall([&](int i) { (void)i; sink = OledFormat::format(buf, sizeof(buf), fmt, __VA_ARGS__); }); \
+    printf("%-10s snprintf %7.1f ns  OledFormat %7.1f ns  (%.2fx)\n", name, lib, own, lib / own); \
+  } while (0)
+
+int main()
+{
+  BENCH("int", "up %lu ms, heap %u", (unsigned long)i * 7, (unsigned)i);
+  BENCH("hex", "reg %08X = %#x", (unsigned)i, (unsigned)i * 3u);
+  BENCH("string", "%s: %-8s ok", "wifi", "connect");
+  BENCH("float", "temp %.2f C, v=%.3f", 21.5 + i * 1e-3, 3.3 - i * 1e-6);
+  BENCH("mixed", "[%5d] %s %.1f%%", i, "load", i * 0.01);
+  return 0;
+}
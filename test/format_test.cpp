@@ -0,0 +1,220 @@
+// Differential test of OledFormat against the C library's vsnprintf over
+// randomly generated conversions, restricted to the behaviour OledFormat.h
+// documents as identical, plus fixed cases for the documented differences.
+#include "OledFormat.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <string>
+
+namespace {
+
+int failures = 0;
+int cases = 0;
+
+// deterministic across runs and platforms
+uint64_t rngState = 0x9E3779B97F4A7C15ull;
+uint64_t rnd()
+{
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 7;
+  rngState ^= rngState << 17;
+  return rngState;
+}
+int rnd(int n) { return (int)(rnd() % (uint64_t)n); }
+
+template <typename... Args>
+void compare(size_t cap, const char* fmt, Args... args)
+{
+  char want[256], got[256];
+  memset(got, 0x7E, sizeof(got));
+  snprintf(want, cap, fmt, args...);
+  int n = OledFormat::format(got, cap, fmt, args...);
+  ++cases;
+  if (strcmp(want, got) != 0 || n != (int)strlen(got)) {
+    if (++failures <= 20) {
+      printf("FAIL cap=%zu fmt=\"%s\": want \"%s\" got \"%s\" (returned %d)\n", cap, fmt, want, got, n);
+    }
+  }
+}
+
+void expect(const char* want, const char* fmt, ...)
+{
+  char got[128];
+  va_list ap;
+  va_start(ap, fmt);
+  OledFormat::vformat(got, sizeof(got), fmt, ap);
+  va_end(ap);
+  ++cases;
+  if (strcmp(want, got) != 0) {
+    ++failures;
+    printf("FAIL fmt=\"%s\": want \"%s\" got \"%s\"\n", fmt, want, got);
+  }
+}
+
+// "%<flags><width>.<prec><len><conv>" from the allowed flag set
+std::string spec(const char* flags, const char* len, char conv, bool allowPrec)
+{
+  std::string s = "%";
+  for (const char* f = flags; *f; ++f) {
+    if (rnd(3) == 0) s += *f;
+  }
+  if (rnd(2)) s += std::to_string(rnd(25));
+  if (allowPrec && rnd(2)) {
+    s += '.';
+    if (rnd(4)) s += std::to_string(rnd(12));
+  }
+  s += len;
+  s += conv;
+  return s;
+}
+
+size_t randomCap()
+{
+  // mostly roomy, sometimes truncating
+  return rnd(4) ? 128 : 1 + (size_t)rnd(16);
+}
+
+long long randomInt()
+{
+  switch (rnd(5)) {
+    case 0:  return 0;
+    case 1:  return (long long)rnd(200) - 100;
+    case 2:  return (long long)(int32_t)rnd();
+    case 3:  return rnd(2) ? INT64_MAX : INT64_MIN;
+    default: return (long long)rnd();
+  }
+}
+
+double randomDouble()
+{
+  switch (rnd(8)) {
+    case 0:  return 0.0;
+    case 1:  return -0.0;
+    case 2:  return rnd(2) ? INFINITY : -INFINITY;
+    case 3:  return NAN;
+    // exact halves at every precision exercise round-half-even
+    case 4:  return (double)rnd(2000) / 8 - 125;
+    case 5:  return (double)rnd(100000) / 1000;
+    default: {
+      // below the documented 1.8e19 limit
+      double m = (double)(rnd() >> 11) / (double)(1ull << 53);
+      double x = m * pow(10.0, rnd(25) - 6);
+      return rnd(2) ? -x : x;
+    }
+  }
+}
+
+void randomCase()
+{
+  static const char* const INT_LENS[] = { "", "hh", "h", "l", "ll", "z", "j", "t" };
+  const char* len = INT_LENS[rnd(8)];
+  const size_t cap = randomCap();
+  std::string fmt;
+
+  switch (rnd(8)) {
+    case 0:
+    case 1: {
+      fmt = spec("-+ 0", len, rnd(2) ? 'd' : 'i', true);
+      long long v = randomInt();
+      if (!strcmp(len, "hh"))     compare(cap, fmt.c_str(), (int)(signed char)v);
+      else if (!strcmp(len, "h")) compare(cap, fmt.c_str(), (int)(short)v);
+      else if (!strcmp(len, "l")) compare(cap, fmt.c_str(), (long)v);
+      else if (!strcmp(len, "ll")) compare(cap, fmt.c_str(), v);
+      else if (!strcmp(len, "z")) compare(cap, fmt.c_str(), (size_t)v);
+      else if (!strcmp(len, "j")) compare(cap, fmt.c_str(), (intmax_t)v);
+      else if (!strcmp(len, "t")) compare(cap, fmt.c_str(), (ptrdiff_t)v);
+      else                        compare(cap, fmt.c_str(), (int)v);
+      break;
+    }
+    case 2:
+    case 3: {
+      static const char CONVS[] = "uxXo";
+      fmt = spec("-#0", len, CONVS[rnd(4)], true);
+      unsigned long long v = (unsigned long long)randomInt();
+      if (!strcmp(len, "hh"))     compare(cap, fmt.c_str(), (unsigned)(unsigned char)v);
+      else if (!strcmp(len, "h")) compare(cap, fmt.c_str(), (unsigned)(unsigned short)v);
+      else if (!strcmp(len, "l")) compare(cap, fmt.c_str(), (unsigned long)v);
+      else if (!strcmp(len, "ll")) compare(cap, fmt.c_str(), v);
+      else if (!strcmp(len, "z")) compare(cap, fmt.c_str(), (size_t)v);
+      else if (!strcmp(len, "j")) compare(cap, fmt.c_str(), (uintmax_t)v);
+      else if (!strcmp(len, "t")) compare(cap, fmt.c_str(), (ptrdiff_t)v);
+      else                        compare(cap, fmt.c_str(), (unsigned)v);
+      break;
+    }
+    case 4:
+    case 5: {
+      // precision capped at 9 digits (documented)
+      fmt = "%";
+      static const char FLAGS[] = "-+ #0";
+      for (int i = 0; i < 5; ++i) {
+        if (rnd(3) == 0) fmt += FLAGS[i];
+      }
+      if (rnd(2)) fmt += std::to_string(rnd(25));
+      if (rnd(3)) fmt += "." + std::to_string(rnd(10));
+      bool ld = rnd(6) == 0;
+      if (ld) fmt += 'L';
+      fmt += rnd(4) ? 'f' : 'F';
+      double v = randomDouble();
+      if (ld) compare(cap, fmt.c_str(), (long double)v);
+      else    compare(cap, fmt.c_str(), v);
+      break;
+    }
+    case 6: {
+      static const char* const WORDS[] = { "", "a", "hello", "with space", "0123456789abcdefghij" };
+      if (rnd(2)) {
+        fmt = spec("-", "", 's', true);
+        compare(cap, fmt.c_str(), WORDS[rnd(5)]);
+      } else {
+        fmt = spec("-", "", 'c', false);
+        compare(cap, fmt.c_str(), 0x20 + rnd(95));
+      }
+      break;
+    }
+    default: {
+      // several conversions and literal text in one format
+      fmt = "id=" + spec("-0", "", 'u', false) + " %s|" + spec("-+", "", 'd', true) + " %% " +
+            spec("-", "", 'x', false) + " v=%.3f";
+      compare(cap, fmt.c_str(), (unsigned)rnd(), "txt", (int)randomInt(), (unsigned)rnd(), randomDouble());
+      break;
+    }
+  }
+}
+
+} // namespace
+
+int main()
+{
+  for (int i = 0; i < 200000; ++i) randomCase();
+
+  // %p (non-null; glibc prints "(nil)" for null)
+  int x;
+  compare(128, "%p", (void*)&x);
+  compare(128, "[%20p]", (void*)&x);
+  compare(128, "[%-20p]", (void*)&x);
+
+  // documented differences: unsupported conversions are copied through,
+  // their arguments consumed so later ones line up
+  expect("%g 7", "%g %d", 1.5, 7);
+  expect("%e|x", "%e|%s", 2.0, "x");
+  expect("%.3E 42", "%.3E %u", 1e10, 42u);
+  expect("%a %G 9", "%a %G %d", 1.0, 2.0, 9);
+  expect("%Lg 5", "%Lg %d", (long double)1.0, 5);
+  expect("%n 3", "%n %d", (int*)nullptr, 3);
+  // %F spells specials in upper case
+  expect("INF -INF NAN", "%F %F %F", INFINITY, -INFINITY, NAN);
+  expect("inf nan", "%f %f", INFINITY, NAN);
+  // precision beyond 9 digits pads with zeros; huge values print ovf
+  expect("0.1250000000000", "%.13f", 0.125);
+  expect("ovf OVF", "%f %F", 1e20, 1e20);
+
+  if (failures) {
+    printf("format_test: %d of %d cases failed\n", failures, cases);
+    return 1;
+  }
+  printf("format_test: ok (%d cases)\n", cases);
+  return 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// Host model of the parts of the Arduino-ESP32 core the library uses. Time
+// is simulated: it only moves when a test (or the Wire bus model) advances
+// it, so bus timings come out the same on every machine.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// the modelled core: Wire.setBufferSize() and a Wire timeout exist
+#define ESP_ARDUINO_VERSION_MAJOR 2
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+// simulated time since boot
+uint32_t millis();
+uint32_t micros();
+void hostAdvanceUs(uint64_t us);
+
+struct HardwareSerial {
+  // silent unless a test turns it on
+  bool echo = false;
+  void println(const char* s) { if (echo) puts(s); }
+};
+extern HardwareSerial Serial;
+
+struct EspClass {
+  uint32_t getCycleCount() { return micros() * 240; }
+  uint32_t getCpuFreqMHz() { return 240; }
+};
+extern EspClass ESP;
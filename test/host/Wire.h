@@ -0,0 +1,55 @@
+#pragma once
+
+// Host model of the arduino-esp32 TwoWire master. Every transaction is
+// recorded; writes past the transmit buffer are refused like on the device,
+// and a transaction whose bus time exceeds the timeout fails with
+// I2C_ERROR_TIMEOUT. Bus time (9 clocks per byte including the address,
+// plus START and STOP) advances the simulated clock.
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#define I2C_BUFFER_LENGTH 128
+
+class TwoWire {
+public:
+  struct Transaction {
+    uint8_t              addr;
+    std::vector<uint8_t> bytes;    // everything after the address byte
+    uint8_t              err;      // endTransmission() result
+    bool                 overflow; // bytes were refused: buffer full
+    uint32_t             us;       // bus time
+  };
+  std::vector<Transaction> transactions;
+  std::vector<uint8_t>     devices = { 0x3C }; // addresses that ACK
+
+  bool begin() { return true; }
+  bool begin(int sda, int scl) { (void)sda; (void)scl; return true; }
+  bool setClock(uint32_t hz) { _clock = hz; return true; }
+  uint32_t getClock() { return _clock; }
+  void setTimeOut(uint16_t ms) { _timeoutMs = ms; }
+  uint16_t getTimeOut() { return _timeoutMs; }
+  // returns the new size, 0 when refused (fixedBuffer models a core or
+  // bus state that cannot grow it)
+  size_t setBufferSize(size_t n) { if (fixedBuffer) return 0; _bufferSize = n; return n; }
+  bool fixedBuffer = false;
+
+  void beginTransmission(uint8_t addr);
+  size_t write(uint8_t b);
+  size_t write(const uint8_t* p, size_t n);
+  uint8_t endTransmission(bool stop = true);
+
+  // bus time of a transaction carrying n bytes after the address
+  uint32_t busUs(size_t n) const;
+  // back to a fresh bus: no transactions, default buffer, clock and timeout
+  void reset() { *this = TwoWire(); }
+
+private:
+  Transaction _tx = {};
+  bool        _open = false;
+  size_t      _bufferSize = I2C_BUFFER_LENGTH;
+  uint32_t    _clock = 100000;
+  uint16_t    _timeoutMs = 50;
+};
+
+extern TwoWire Wire;
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdlib.h>
+
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+
+inline void* heap_caps_calloc(size_t n, size_t size, unsigned caps) { (void)caps; return calloc(n, size); }
+inline size_t heap_caps_get_free_size(unsigned caps) { (void)caps; return 200 * 1024; }
+inline size_t heap_caps_get_largest_free_block(unsigned caps) { (void)caps; return 100 * 1024; }
+inline size_t heap_caps_get_minimum_free_size(unsigned caps) { (void)caps; return 150 * 1024; }
@@ -0,0 +1,24 @@
+#pragma once
+
+// Host model of the FreeRTOS types and macros the library uses. One tick is
+// one millisecond of simulated time; there is no scheduler, so tests run the
+// logger in polled mode (service()).
+#include <stdint.h>
+#include <stddef.h>
+
+typedef int           BaseType_t;
+typedef unsigned      UBaseType_t;
+typedef uint32_t      TickType_t;
+typedef void*         TaskHandle_t;
+typedef struct Queue* QueueHandle_t;
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  pdTRUE
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFFu)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portYIELD_FROM_ISR(woken) (void)(woken)
+#define portNUM_PROCESSORS 2
+
+#define configUSE_TRACE_FACILITY 0
+#define configGENERATE_RUN_TIME_STATS 0
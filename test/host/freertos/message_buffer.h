@@ -0,0 +1,15 @@
+#pragma once
+
+// Host model of a FreeRTOS message buffer: each message is copied in and out
+// behind a length word (4 bytes, as on the ESP32). One byte of the storage
+// is never used, as in a stream buffer. Waits fail at once.
+#include "FreeRTOS.h"
+
+typedef struct MessageBuffer* MessageBufferHandle_t;
+
+MessageBufferHandle_t xMessageBufferCreate(size_t size);
+void vMessageBufferDelete(MessageBufferHandle_t mb);
+size_t xMessageBufferSend(MessageBufferHandle_t mb, const void* data, size_t size, TickType_t wait);
+size_t xMessageBufferSendFromISR(MessageBufferHandle_t mb, const void* data, size_t size, BaseType_t* woken);
+size_t xMessageBufferReceive(MessageBufferHandle_t mb, void* data, size_t size, TickType_t wait);
+size_t xMessageBufferSpacesAvailable(MessageBufferHandle_t mb);
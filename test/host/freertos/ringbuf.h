@@ -0,0 +1,23 @@
+#pragma once
+
+// Host model of an ESP-IDF no-split ring buffer. Items are stored in place
+// behind an 8-byte header, 4-byte aligned, and never wrap: one that does not
+// fit before the end starts over at offset 0. Space is freed in order, up to
+// the oldest item not yet returned, so a record held by the reader pins
+// everything sent after it. A wait on a full or empty ring fails at once.
+#include "FreeRTOS.h"
+
+typedef struct Ringbuffer* RingbufHandle_t;
+typedef enum { RINGBUF_TYPE_NOSPLIT = 0 } RingbufferType_t;
+
+RingbufHandle_t xRingbufferCreate(size_t size, RingbufferType_t type);
+void vRingbufferDelete(RingbufHandle_t rb);
+size_t xRingbufferGetMaxItemSize(RingbufHandle_t rb);
+size_t xRingbufferGetCurFreeSize(RingbufHandle_t rb);
+BaseType_t xRingbufferSend(RingbufHandle_t rb, const void* item, size_t size, TickType_t wait);
+BaseType_t xRingbufferSendFromISR(RingbufHandle_t rb, const void* item, size_t size, BaseType_t* woken);
+void* xRingbufferReceive(RingbufHandle_t rb, size_t* size, TickType_t wait);
+void vRingbufferReturnItem(RingbufHandle_t rb, void* item);
+// IDF 4.x signature (with the acquire pointer)
+void vRingbufferGetInfo(RingbufHandle_t rb, UBaseType_t* free, UBaseType_t* read, UBaseType_t* write,
+                        UBaseType_t* acquire, UBaseType_t* waiting);
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void*);
+
+// no scheduler: task creation always fails, tests use polled mode
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack,
+                                          void* arg, UBaseType_t prio, TaskHandle_t* handle,
+                                          BaseType_t core)
+{
+  (void)fn; (void)name; (void)stack; (void)arg; (void)prio; (void)handle; (void)core;
+  return pdFALSE;
+}
+
+TickType_t xTaskGetTickCount();
+inline UBaseType_t uxTaskGetNumberOfTasks() { return 1; }
@@ -0,0 +1,340 @@
+// Implementations behind the host model headers in this directory.
+#include "Arduino.h"
+#include "Wire.h"
+#include "freertos/queue.h"
+#include "freertos/ringbuf.h"
+#include "freertos/message_buffer.h"
+#include <string.h>
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+// the logger is a process-wide singleton that tests begin() several times
+// and never tear down
+extern "C" const char* __asan_default_options() { return "detect_leaks=0"; }
+
+HardwareSerial Serial;
+EspClass ESP;
+TwoWire Wire;
+
+// --- simulated time ---
+
+static uint64_t hostUs = 0;
+
+uint32_t millis() { return (uint32_t)(hostUs / 1000); }
+uint32_t micros() { return (uint32_t)hostUs; }
+void hostAdvanceUs(uint64_t us) { hostUs += us; }
+TickType_t xTaskGetTickCount() { return (TickType_t)millis(); }
+
+// --- Wire ---
+
+void TwoWire::beginTransmission(uint8_t addr)
+{
+  _tx = Transaction();
+  _tx.addr = addr;
+  _open = true;
+}
+
+size_t TwoWire::write(uint8_t b)
+{
+  return write(&b, 1);
+}
+
+size_t TwoWire::write(const uint8_t* p, size_t n)
+{
+  if (!_open) return 0;
+  size_t room = _bufferSize - std::min(_bufferSize, _tx.bytes.size());
+  size_t take = std::min(room, n);
+  _tx.bytes.insert(_tx.bytes.end(), p, p + take);
+  if (take < n) _tx.overflow = true;
+  return take;
+}
+
+uint32_t TwoWire::busUs(size_t n) const
+{
+  // address byte plus n bytes at 9 clocks each, START and STOP
+  uint64_t clocks = (uint64_t)(n + 1) * 9 + 2;
+  return (uint32_t)((clocks * 1000000 + _clock - 1) / _clock);
+}
+
+uint8_t TwoWire::endTransmission(bool stop)
+{
+  (void)stop;
+  if (!_open) return 4;
+  _open = false;
+  _tx.us = busUs(_tx.bytes.size());
+  if (std::find(devices.begin(), devices.end(), _tx.addr) == devices.end()) {
+    _tx.err = 2; // address NACK: the transaction stops after the address byte
+    _tx.us = busUs(0);
+  } else if (_tx.us > (uint32_t)_timeoutMs * 1000) {
+    _tx.err = 5; // I2C_ERROR_TIMEOUT: the driver gives up at the timeout
+    _tx.us = (uint32_t)_timeoutMs * 1000;
+  }
+  hostAdvanceUs(_tx.us);
+  transactions.push_back(_tx);
+  return _tx.err;
+}
+
+// --- queue ---
+
+struct Queue {
+  std::vector<uint8_t> storage; // length items of itemSize bytes
+  size_t               itemSize;
+  size_t               head;    // oldest item
+  size_t               count;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+  Queue* q = new Queue;
+  q->storage.resize((size_t)length * itemSize);
+  q->itemSize = itemSize;
+  q->head = 0;
+  q->count = 0;
+  return q;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+  delete q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait)
+{
+  (void)wait;
+  const size_t length = q->storage.size() / q->itemSize;
+  if (q->count >= length) return pdFALSE;
+  memcpy(&q->storage[(q->head + q->count) % length * q->itemSize], item, q->itemSize);
+  q->count++;
+  return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void* item, BaseType_t* woken)
+{
+  if (woken) *woken = pdFALSE;
+  return xQueueSend(q, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t wait)
+{
+  (void)wait;
+  if (!q->count) return pdFALSE;
+  memcpy(item, &q->storage[q->head * q->itemSize], q->itemSize);
+  q->head = (q->head + 1) % (q->storage.size() / q->itemSize);
+  q->count--;
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+  return (UBaseType_t)q->count;
+}
+
+// --- no-split ring buffer ---
+
+static const size_t RB_HEADER = 8;
+static size_t rbAlign(size_t n) { return (n + 3) & ~(size_t)3; }
+
+struct Ringbuffer {
+  enum : uint8_t { WAITING, RETRIEVED, RETURNED };
+  struct Item {
+    size_t  off;  // header offset; the data follows it
+    size_t  span; // header plus aligned data
+    size_t  len;
+    uint8_t state;
+  };
+  std::vector<uint8_t> buf;
+  std::deque<Item>     items; // oldest first, none freed yet
+  size_t               wr;    // next write offset
+
+  // start of the oldest space not yet freed
+  size_t freeEnd() const { return items.empty() ? wr : items.front().off; }
+
+  // where an item of span bytes would go, false if it does not fit now
+  bool place(size_t span, size_t* off) const
+  {
+    const size_t n = buf.size(), fr = freeEnd();
+    if (items.empty()) {
+      *off = (n - wr >= span) ? wr : 0;
+      return true;
+    }
+    if (wr == fr) return false; // full
+    if (fr > wr) {
+      *off = wr;
+      return span <= fr - wr;
+    }
+    if (span <= n - wr) {
+      *off = wr;
+      return true;
+    }
+    *off = 0; // skip the tail, start over at the head
+    return span <= fr;
+  }
+};
+
+RingbufHandle_t xRingbufferCreate(size_t size, RingbufferType_t type)
+{
+  (void)type;
+  Ringbuffer* rb = new Ringbuffer;
+  rb->buf.resize(rbAlign(size));
+  rb->wr = 0;
+  return rb;
+}
+
+void vRingbufferDelete(RingbufHandle_t rb)
+{
+  delete rb;
+}
+
+size_t xRingbufferGetMaxItemSize(RingbufHandle_t rb)
+{
+  return rbAlign(rb->buf.size() / 2) - RB_HEADER;
+}
+
+size_t xRingbufferGetCurFreeSize(RingbufHandle_t rb)
+{
+  // the largest item that could be sent now
+  const size_t n = rb->buf.size(), fr = rb->freeEnd();
+  size_t room;
+  if (rb->items.empty()) room = n;
+  else if (rb->wr == fr) room = 0;
+  else if (fr > rb->wr) room = fr - rb->wr;
+  else room = std::max(n - rb->wr, fr);
+  room = room > RB_HEADER ? room - RB_HEADER : 0;
+  return std::min(room, xRingbufferGetMaxItemSize(rb));
+}
+
+BaseType_t xRingbufferSend(RingbufHandle_t rb, const void* item, size_t size, TickType_t wait)
+{
+  (void)wait;
+  if (size > xRingbufferGetMaxItemSize(rb)) return pdFALSE;
+  const size_t span = RB_HEADER + rbAlign(size);
+  size_t off;
+  if (!rb->place(span, &off)) return pdFALSE;
+  memcpy(&rb->buf[off + RB_HEADER], item, size);
+  rb->items.push_back({ off, span, size, Ringbuffer::WAITING });
+  rb->wr = (off + span) % rb->buf.size();
+  return pdTRUE;
+}
+
+BaseType_t xRingbufferSendFromISR(RingbufHandle_t rb, const void* item, size_t size, BaseType_t* woken)
+{
+  if (woken) *woken = pdFALSE;
+  return xRingbufferSend(rb, item, size, 0);
+}
+
+void* xRingbufferReceive(RingbufHandle_t rb, size_t* size, TickType_t wait)
+{
+  (void)wait;
+  for (Ringbuffer::Item& it : rb->items) {
+    if (it.state != Ringbuffer::WAITING) continue;
+    it.state = Ringbuffer::RETRIEVED;
+    *size = it.len;
+    return &rb->buf[it.off + RB_HEADER];
+  }
+  return nullptr;
+}
+
+void vRingbufferReturnItem(RingbufHandle_t rb, void* item)
+{
+  for (Ringbuffer::Item& it : rb->items) {
+    if (&rb->buf[it.off + RB_HEADER] == item) it.state = Ringbuffer::RETURNED;
+  }
+  // space is freed in order only
+  while (!rb->items.empty() && rb->items.front().state == Ringbuffer::RETURNED) rb->items.pop_front();
+}
+
+void vRingbufferGetInfo(RingbufHandle_t rb, UBaseType_t* free, UBaseType_t* read, UBaseType_t* write,
+                        UBaseType_t* acquire, UBaseType_t* waiting)
+{
+  UBaseType_t n = 0, rd = (UBaseType_t)rb->wr;
+  for (const Ringbuffer::Item& it : rb->items) {
+    if (it.state != Ringbuffer::WAITING) continue;
+    if (!n) rd = (UBaseType_t)it.off;
+    n++;
+  }
+  if (free) *free = (UBaseType_t)rb->freeEnd();
+  if (read) *read = rd;
+  if (write) *write = (UBaseType_t)rb->wr;
+  if (acquire) *acquire = (UBaseType_t)rb->wr;
+  if (waiting) *waiting = n;
+}
+
+// --- message buffer ---
+
+static const size_t MB_LENGTH = 4;
+
+struct MessageBuffer {
+  std::vector<uint8_t> buf;
+  size_t               head; // oldest byte
+  size_t               used;
+
+  // copies in at most two pieces, around the end of the storage
+  void put(const void* p, size_t n)
+  {
+    const size_t at = (head + used) % buf.size(), first = std::min(n, buf.size() - at);
+    memcpy(&buf[at], p, first);
+    memcpy(&buf[0], (const uint8_t*)p + first, n - first);
+    used += n;
+  }
+  void get(void* p, size_t n)
+  {
+    const size_t first = std::min(n, buf.size() - head);
+    memcpy(p, &buf[head], first);
+    memcpy((uint8_t*)p + first, &buf[0], n - first);
+    head = (head + n) % buf.size();
+    used -= n;
+  }
+};
+
+MessageBufferHandle_t xMessageBufferCreate(size_t size)
+{
+  MessageBuffer* mb = new MessageBuffer;
+  mb->buf.resize(size);
+  mb->head = 0;
+  mb->used = 0;
+  return mb;
+}
+
+void vMessageBufferDelete(MessageBufferHandle_t mb)
+{
+  delete mb;
+}
+
+size_t xMessageBufferSpacesAvailable(MessageBufferHandle_t mb)
+{
+  return mb->buf.size() - 1 - mb->used;
+}
+
+size_t xMessageBufferSend(MessageBufferHandle_t mb, const void* data, size_t size, TickType_t wait)
+{
+  (void)wait;
+  if (MB_LENGTH + size > xMessageBufferSpacesAvailable(mb)) return 0;
+  uint32_t len = (uint32_t)size;
+  mb->put(&len, MB_LENGTH);
+  mb->put(data, size);
+  return size;
+}
+
+size_t xMessageBufferSendFromISR(MessageBufferHandle_t mb, const void* data, size_t size, BaseType_t* woken)
+{
+  if (woken) *woken = pdFALSE;
+  return xMessageBufferSend(mb, data, size, 0);
+}
+
+size_t xMessageBufferReceive(MessageBufferHandle_t mb, void* data, size_t size, TickType_t wait)
+{
+  (void)wait;
+  if (!mb->used) return 0;
+  uint32_t len;
+  const size_t head = mb->head;
+  mb->get(&len, MB_LENGTH);
+  if (len > size) {
+    // too small for the next message: it stays queued
+    mb->head = head;
+    mb->used += MB_LENGTH;
+    return 0;
+  }
+  mb->get(data, len);
+  return len;
+}
@@ -0,0 +1,190 @@
+// Flush path on the host bus model (host/Wire.h): every transaction must fit
+// the Wire buffer and finish inside the Wire timeout at the configured
+// clock, and the stats must account for every byte on the wire. Prints the
+// cost of a frame and a line update next to Adafruit's display().
+#include <stdarg.h>
+#include <stdio.h>
+#include <type_traits>
+#include <vector>
+#include "Arduino.h"
+#include "Wire.h"
+// the task-mode frame sequence is private; no scheduler runs it here
+#define private public
+#include "OledLogger.h"
+#undef private
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const char* what, ...)
+{
+  if (ok) return;
+  ++failures;
+  va_list ap;
+  va_start(ap, what);
+  printf("FAIL ");
+  vprintf(what, ap);
+  printf("\n");
+  va_end(ap);
+}
+
+// bytes on the wire (address byte included) of transactions [from, end)
+size_t wireBytes(size_t from)
+{
+  size_t n = 0;
+  for (size_t i = from; i < Wire.transactions.size(); ++i) n += 1 + Wire.transactions[i].bytes.size();
+  return n;
+}
+
+// every transaction from `from` on was accepted whole and in time
+void checkTransactions(const char* scenario, size_t from)
+{
+  const uint32_t limitUs = (uint32_t)Wire.getTimeOut() * 1000;
+  for (size_t i = from; i < Wire.transactions.size(); ++i) {
+    const TwoWire::Transaction& t = Wire.transactions[i];
+    expect(!t.overflow, "%s: transaction %zu overflowed the Wire buffer", scenario, i);
+    expect(t.err == 0, "%s: transaction %zu failed (%u)", scenario, i, (unsigned)t.err);
+    expect(t.us <= limitUs, "%s: transaction %zu took %u us, timeout %u us", scenario, i, t.us, limitUs);
+  }
+}
+
+// Adafruit_SSD1306::display() of a full frame on the same core: a
+// 5-command list and a single command, then data in chunks of the Wire
+// buffer less the 0x40 control byte
+void adafruitFrame(size_t frameBytes, size_t wireMax, size_t* transactions, size_t* overhead)
+{
+  size_t chunks = (frameBytes + wireMax - 2) / (wireMax - 1);
+  *transactions = 2 + chunks;
+  *overhead = (1 + 1 + 5) + (1 + 1 + 1) + chunks * 2;
+}
+
+// begin() in polled mode on a fresh bus
+void start(uint16_t timeoutMs, bool fixedBuffer)
+{
+  Wire.reset();
+  Wire.setTimeOut(timeoutMs);
+  Wire.fixedBuffer = fixedBuffer;
+  bool ok = OledLogger::begin(0x3C, 128, 64, -1, -1, 16, 1, 1, false);
+  expect(ok, "begin failed");
+}
+
+// the render task's first frame: startup records, then every page at once.
+// Returns the transactions and overhead bytes of the frame.
+void taskFirstFrame(const char* scenario, size_t wireMax, size_t* txOut, size_t* overheadOut)
+{
+  OledLogger::logf("first");
+  OledLogger::Stats before;
+  OledLogger::getStats(before);
+  size_t from = Wire.transactions.size();
+
+  OledLogger::msg_t scratch;
+  OledLogger::startFrame(scratch);
+  OledLogger::flushDirty(false);
+  size_t frameEnd = Wire.transactions.size();
+  OledLogger::displayOn();
+
+  OledLogger::Stats after;
+  OledLogger::getStats(after);
+  checkTransactions(scenario, from);
+  expect(after.i2c_errors == before.i2c_errors, "%s: errors counted", scenario);
+  expect(after.i2c_transactions - before.i2c_transactions == Wire.transactions.size() - from,
+         "%s: transaction count", scenario);
+  expect((after.i2c_overhead_bytes - before.i2c_overhead_bytes) +
+           (after.i2c_data_bytes - before.i2c_data_bytes) == wireBytes(from),
+         "%s: stats do not add up to the bytes on the wire", scenario);
+  expect(after.i2c_data_bytes - before.i2c_data_bytes == 1024, "%s: frame data bytes", scenario);
+
+  // one 13-byte addressing header, then 2 bytes (address, 0x40) per split
+  size_t frameTx = frameEnd - from;
+  size_t frameOverhead = 0;
+  for (size_t i = from; i < frameEnd; ++i) frameOverhead += 1 + Wire.transactions[i].bytes.size();
+  frameOverhead -= 1024;
+  expect(frameOverhead == 14 + 2 * (frameTx - 1), "%s: %zu overhead bytes in %zu transactions",
+         scenario, frameOverhead, frameTx);
+
+  uint32_t us = 0;
+  for (size_t i = from; i < frameEnd; ++i) us += Wire.transactions[i].us;
+  printf("%-28s frame: %2zu transactions, %2zu overhead bytes, %5.1f ms, max %zu bytes each\n",
+         scenario, frameTx, frameOverhead, us / 1000.0, wireMax);
+  *txOut = frameTx;
+  *overheadOut = frameOverhead;
+}
+
+// a one-line update in polled mode: the changed pages only, one
+// transaction each
+void pageFlush()
+{
+  OledLogger::Stats before;
+  OledLogger::getStats(before);
+  size_t from = Wire.transactions.size();
+  OledLogger::logf("next line");
+  OledLogger::service(100000);
+  OledLogger::Stats after;
+  OledLogger::getStats(after);
+
+  checkTransactions("page flush", from);
+  size_t tx = Wire.transactions.size() - from;
+  size_t afTx, afOverhead;
+  adafruitFrame(1024, I2C_BUFFER_LENGTH, &afTx, &afOverhead);
+  expect(tx >= 1, "page flush: nothing sent");
+  // the new line scrolls every text page: one header per page
+  expect(after.i2c_overhead_bytes - before.i2c_overhead_bytes == 14 * tx, "page flush: %u overhead bytes for %zu pages",
+         (unsigned)(after.i2c_overhead_bytes - before.i2c_overhead_bytes), tx);
+  expect(after.i2c_data_bytes - before.i2c_data_bytes == 128 * tx, "page flush: data bytes");
+  printf("%-28s %zu page(s): %zu bytes on the wire (Adafruit display(): %zu)\n", "line update", tx,
+         wireBytes(from), 1024 + afOverhead);
+  expect(wireBytes(from) < 1024 + afOverhead, "page flush: not smaller than a full frame");
+}
+
+// panel gone: every failed transaction is counted
+void failuresCounted()
+{
+  OledLogger::Stats before;
+  OledLogger::getStats(before);
+  size_t from = Wire.transactions.size();
+  Wire.devices.clear();
+  OledLogger::logf("lost");
+  OledLogger::service(100000);
+  OledLogger::Stats after;
+  OledLogger::getStats(after);
+  size_t tx = Wire.transactions.size() - from;
+  expect(tx > 0 && after.i2c_errors - before.i2c_errors == tx, "failed transactions not counted (%u of %zu)",
+         (unsigned)(after.i2c_errors - before.i2c_errors), tx);
+  Wire.devices.push_back(0x3C);
+}
+
+} // namespace
+
+int main()
+{
+  size_t afTx, afOverhead, tx, overhead;
+  adafruitFrame(1024, I2C_BUFFER_LENGTH, &afTx, &afOverhead);
+  printf("%-28s frame: %2zu transactions, %2zu overhead bytes\n", "Adafruit display()", afTx, afOverhead);
+
+  // default Wire timeout: the enlarged buffer is capped by bus time, and
+  // a frame still costs fewer transactions and overhead bytes
+  start(50, false);
+  taskFirstFrame("50 ms timeout, 1040 B buffer", OledLogger::_wireMax, &tx, &overhead);
+  expect(OledLogger::_wireMax == 277, "cap at 50 ms and 100 kHz: %zu", OledLogger::_wireMax);
+  expect(tx < afTx && overhead < afOverhead, "large transactions: no saving over Adafruit");
+  pageFlush();
+  failuresCounted();
+
+  // short timeout: smaller transactions, still all in time
+  start(5, false);
+  taskFirstFrame("5 ms timeout", OledLogger::_wireMax, &tx, &overhead);
+
+  // buffer cannot grow: chunked at the core's buffer size (the addressing
+  // header costs 3 bytes more than Adafruit's, in one transaction less)
+  start(50, true);
+  taskFirstFrame("fixed 128 B buffer", OledLogger::_wireMax, &tx, &overhead);
+  expect(OledLogger::_wireMax == I2C_BUFFER_LENGTH, "fixed buffer: %zu", OledLogger::_wireMax);
+
+  if (failures) {
+    printf("i2c_test: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("i2c_test: ok\n");
+  return 0;
+}
@@ -0,0 +1,122 @@
+// Randomized test of OledKernels against plain byte-loop references, over
+// every head/tail alignment and length the renderer can produce.
+#include "OledKernels.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+int failures = 0;
+int cases = 0;
+
+// deterministic across runs and platforms
+uint64_t rngState = 0x9E3779B97F4A7C15ull;
+uint64_t rnd()
+{
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 7;
+  rngState ^= rngState << 17;
+  return rngState;
+}
+int rnd(int n) { return (int)(rnd() % (uint64_t)n); }
+
+const size_t SIZE = 160;
+const size_t GUARD = 8;
+
+void randomBytes(uint8_t* p, size_t n)
+{
+  for (size_t i = 0; i < n; ++i) p[i] = (uint8_t)rnd();
+}
+
+void check(bool ok, const char* what, size_t off, size_t n)
+{
+  ++cases;
+  if (!ok && ++failures <= 20) {
+    printf("FAIL %s offset=%zu n=%zu\n", what, off, n);
+  }
+}
+
+// the kernel touched dst[off, off+n) exactly as the reference did, and
+// nothing outside it
+void compareBuffers(const char* what, const uint8_t* want, const uint8_t* got, size_t off, size_t n)
+{
+  check(memcmp(want, got, SIZE) == 0, what, off, n);
+}
+
+void randomCase()
+{
+  // 16-byte aligned storage, so offset covers every word alignment
+  alignas(16) uint8_t want[SIZE], got[SIZE], src[SIZE], other[SIZE];
+  const size_t off = (size_t)rnd(8);
+  const size_t n = (size_t)rnd((int)(SIZE - 2 * GUARD));
+  randomBytes(want, SIZE);
+  memcpy(got, want, SIZE);
+  randomBytes(src, SIZE);
+
+  switch (rnd(5)) {
+    case 0: {
+      uint8_t v = (uint8_t)rnd();
+      for (size_t i = 0; i < n; ++i) want[off + i] = v;
+      OledKernels::fill(got + off, v, n);
+      compareBuffers("fill", want, got, off, n);
+      break;
+    }
+    case 1: {
+      // same or different alignment of source and destination
+      const size_t soff = (size_t)rnd(8);
+      for (size_t i = 0; i < n; ++i) want[off + i] = src[soff + i];
+      OledKernels::copy(got + off, src + soff, n);
+      compareBuffers("copy", want, got, off, n);
+      break;
+    }
+    case 2: {
+      for (size_t i = 0; i < n; ++i) want[off + i] = (uint8_t)~want[off + i];
+      OledKernels::invert(got + off, n);
+      compareBuffers("invert", want, got, off, n);
+      break;
+    }
+    case 3: {
+      uint8_t even = (uint8_t)rnd(), odd = (uint8_t)rnd();
+      for (size_t i = 0; i < n; ++i) want[off + i] &= (i & 1) ? odd : even;
+      OledKernels::maskAlternate(got + off, n, even, odd);
+      compareBuffers("maskAlternate", want, got, off, n);
+      break;
+    }
+    default: {
+      // a copy with a few flipped bytes, or none, at any alignment pair
+      const size_t boff = (size_t)rnd(8);
+      memcpy(other + boff, want + off, n);
+      for (int k = rnd(4); k > 0 && n; --k) other[boff + (size_t)rnd((int)n)] ^= (uint8_t)(1 + rnd(255));
+      size_t lo = n, hi = n;
+      for (size_t i = 0; i < n; ++i) {
+        if (want[off + i] != other[boff + i]) {
+          if (lo == n) lo = i;
+          hi = i;
+        }
+      }
+      size_t first = SIZE, last = SIZE;
+      bool differ = OledKernels::diff(want + off, other + boff, n, &first, &last);
+      check(differ == (lo != n), "diff result", off, n);
+      if (differ && lo != n) {
+        check(first == lo && last == hi, "diff range", off, n);
+      }
+      check(OledKernels::diff(want + off, other + boff, n, nullptr, nullptr) == differ, "diff null", off, n);
+      break;
+    }
+  }
+}
+
+} // namespace
+
+int main()
+{
+  for (int i = 0; i < 200000; ++i) randomCase();
+
+  if (failures) {
+    printf("kernels_test: %d of %d checks failed\n", failures, cases);
+    return 1;
+  }
+  printf("kernels_test: ok (%d checks)\n", cases);
+  return 0;
+}
@@ -0,0 +1,91 @@
+// OLED_LOG_CONST rows (compile-time OledRaster::rasterize) must match what
+// the render task draws for the same text at runtime (OledRaster::drawText),
+// pixel for pixel.
+#include "OledRaster.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+namespace {
+
+const int WIDTH = 128;
+
+int failures = 0;
+
+template <size_t W>
+void check(const char* txt, const OledRaster::Raster<W>& raster)
+{
+  uint8_t row[WIDTH] = {};
+  OledRaster::drawText(row, WIDTH, txt, nullptr, 0);
+  // drawLine copies min(raster width, panel width) columns into a clear row
+  uint8_t fromRaster[WIDTH] = {};
+  memcpy(fromRaster, raster.cols, std::min((int)W, WIDTH));
+
+  for (int x = 0; x < WIDTH; ++x) {
+    if (row[x] != fromRaster[x]) {
+      printf("FAIL \"%s\": column %d runtime %02X raster %02X\n", txt, x, row[x], fromRaster[x]);
+      ++failures;
+      return;
+    }
+  }
+}
+
+// icons replace one character with their own columns and clip at the
+// right edge like glyphs
+void checkIcons()
+{
+  static const OledIcon icons[2] = {
+    { 8, { 1, 2, 3, 4, 5, 6, 7, 8 } },
+    { 3, { 9, 9, 0 } },
+  };
+  uint8_t row[WIDTH] = {};
+  OledRaster::drawText(row, WIDTH, "\x10" "A" "\x11" "\x12", icons, 2);
+  uint8_t want[WIDTH] = {};
+  memcpy(want, icons[0].cols, 8);
+  memcpy(want + 8, OledFont::glyph('A'), OledFont::GLYPH_W);
+  memcpy(want + 8 + OledFont::ADVANCE, icons[1].cols, 3);
+  // past the table: the invalid glyph
+  memcpy(want + 8 + OledFont::ADVANCE + 3, OledFont::glyph('\x12'), OledFont::GLYPH_W);
+  if (memcmp(row, want, WIDTH)) {
+    printf("FAIL icons\n");
+    ++failures;
+  }
+
+  uint8_t edge[WIDTH + 4] = {};
+  memset(edge + WIDTH, 0xEE, 4);
+  char txt[23];
+  memset(txt, 'x', 21);
+  txt[21] = '\x10';
+  txt[22] = '\0';
+  OledRaster::drawText(edge, WIDTH, txt, icons, 2);
+  if (memcmp(edge + 126, icons[0].cols, 2) || edge[WIDTH] != 0xEE) {
+    printf("FAIL icon at the right edge\n");
+    ++failures;
+  }
+}
+
+} // namespace
+
+// evaluated at compile time, as OLED_LOG_CONST does
+#define CHECK(str) \
+  do { \
+    static constexpr OledRaster::Raster<(sizeof(str) - 1) * OledFont::ADVANCE> r = OledRaster::rasterize(str); \
+    check(str, r); \
+  } while (0)
+
+int main()
+{
+  CHECK("BOOT OK ~{}");
+  CHECK("a");
+  CHECK(" !\"#$%&'()*+,-./0123456789:;<=>?");
+  CHECK("@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_");
+  CHECK("`abcdefghijklmnopqrstuvwxyz{|}~");
+  CHECK("21 chars fill 126 px");
+  CHECK("31-char line clipped at 128 px!");
+  CHECK("\x7f\x01 out of range -> invalid");
+  checkIcons();
+
+  if (failures) return 1;
+  printf("raster_test: ok\n");
+  return 0;
+}
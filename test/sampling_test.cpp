@@ -0,0 +1,76 @@
+// OLED_LOG_EVERY_N / OLED_LOG_EVERY_MS: the first pass is logged, even
+// within ms of boot, and n < 1 logs every pass instead of wrapping.
+#include <stdarg.h>
+#include <stdio.h>
+#include "Arduino.h"
+#include "Wire.h"
+#include "OledLogger.h"
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const char* what, ...)
+{
+  if (ok) return;
+  ++failures;
+  va_list ap;
+  va_start(ap, what);
+  printf("FAIL ");
+  vprintf(what, ap);
+  printf("\n");
+  va_end(ap);
+}
+
+int logged = 0;
+
+void count(OledLogger::Level level, uint8_t tag, const char* text, void* ctx)
+{
+  (void)level; (void)tag; (void)text; (void)ctx;
+  ++logged;
+}
+
+// records logged by f, once drained
+template <typename F>
+int run(F f)
+{
+  logged = 0;
+  f();
+  for (int i = 0; i < 100; ++i) OledLogger::service(100000);
+  return logged;
+}
+
+void everyN(int n) { OLED_LOG_EVERY_N(n, OledLogger::LEVEL_INFO, 0, "n"); }
+void everyNZero() { OLED_LOG_EVERY_N(0, OledLogger::LEVEL_INFO, 0, "zero"); }
+void everyMs() { OLED_LOG_EVERY_MS(1000, OledLogger::LEVEL_INFO, 0, "ms"); }
+
+} // namespace
+
+int main()
+{
+  // headless polled logger: records only reach subscribers
+  Wire.devices.clear();
+  bool ok = OledLogger::begin(0x3C, 128, 64, -1, -1, 16, 1, 1, false);
+  expect(ok, "begin failed");
+  OledLogger::setPanelProbe(0);
+  OledLogger::subscribe(count);
+
+  // right after boot: millis() is still below the period
+  expect(millis() < 1000, "clock already at %u ms", (unsigned)millis());
+  int n = run([] { everyMs(); });
+  expect(n == 1, "EVERY_MS: first pass within ms of boot logged %d", n);
+  n = run([] { for (int i = 0; i < 5; ++i) { hostAdvanceUs(300000); everyMs(); } });
+  expect(n == 1, "EVERY_MS: %d logged in 1.5 s at a 1 s period", n);
+
+  n = run([] { for (int i = 0; i < 7; ++i) everyN(3); });
+  expect(n == 3, "EVERY_N(3): %d of 7 passes logged", n);
+  n = run([] { for (int i = 0; i < 5; ++i) everyNZero(); });
+  expect(n == 5, "EVERY_N(0): %d of 5 passes logged", n);
+
+  if (failures) {
+    printf("sampling_test: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("sampling_test: ok\n");
+  return 0;
+}
@@ -0,0 +1,175 @@
+// Time from begin() to the first line on the panel, on the host bus model
+// (host/Wire.h, 100 kHz): probe, the one-transaction init sequence, the
+// first frame carrying what was logged meanwhile, display on. The simulated
+// clock only advances with bus time, so startup_us is the bus cost.
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+#include <vector>
+#include "Arduino.h"
+#include "Wire.h"
+// the task-mode startup sequence is private; no scheduler runs it here
+#define private public
+#include "OledLogger.h"
+#undef private
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const char* what, ...)
+{
+  if (ok) return;
+  ++failures;
+  va_list ap;
+  va_start(ap, what);
+  printf("FAIL ");
+  vprintf(what, ap);
+  printf("\n");
+  va_end(ap);
+}
+
+// transactions [from, to): count, bytes on the wire (address included), bus time
+struct Cost {
+  size_t   tx;
+  size_t   bytes;
+  uint32_t us;
+};
+
+Cost cost(size_t from, size_t to)
+{
+  Cost c = { to - from, 0, 0 };
+  for (size_t i = from; i < to; ++i) {
+    c.bytes += 1 + Wire.transactions[i].bytes.size();
+    c.us += Wire.transactions[i].us;
+  }
+  return c;
+}
+
+void report(const char* phase, const Cost& c)
+{
+  printf("  %-22s %2zu transaction(s) %5zu bytes %7.2f ms\n", phase, c.tx, c.bytes, c.us / 1000.0);
+}
+
+// polled begin() on a fresh bus
+bool begin()
+{
+  Wire.reset();
+  return OledLogger::begin(0x3C, 128, 64, -1, -1, 16, 1, 1, false);
+}
+
+// begin() side: a probe and a single init transaction, display still off
+void checkBegin(const char* mode)
+{
+  const std::vector<TwoWire::Transaction>& t = Wire.transactions;
+  expect(t.size() == 2, "%s: begin() sent %zu transactions", mode, t.size());
+  if (t.size() < 2) return;
+  expect(t[0].bytes.empty(), "%s: first transaction is not the probe", mode);
+  expect(t[1].bytes.size() > 1 && t[1].bytes[0] == 0x00 && t[1].bytes[1] == 0xAE,
+         "%s: second transaction is not the command list", mode);
+  for (size_t i = 2; i < t[1].bytes.size(); ++i) {
+    expect(t[1].bytes[i] != 0xAF, "%s: display turned on during init", mode);
+  }
+}
+
+// after the first frame: one full frame of data (no blank clear frame), the
+// line logged during startup in it, display on last, and startup_us equal
+// to the bus time since begin()
+void checkStartup(const char* mode, uint64_t beginUs, const OledLogger::Stats& before)
+{
+  const std::vector<TwoWire::Transaction>& t = Wire.transactions;
+  OledLogger::Stats s;
+  OledLogger::getStats(s);
+  const uint32_t data = s.i2c_data_bytes - before.i2c_data_bytes;
+  expect(OledLogger::_started, "%s: not started", mode);
+  expect(data == 1024, "%s: %u data bytes, one frame is 1024", mode, (unsigned)data);
+  expect(t.back().bytes.size() == 2 && t.back().bytes[1] == 0xAF, "%s: display on is not last", mode);
+  bool drawn = false;
+  for (int x = 0; x < 128 * 8; ++x) drawn |= OledLogger::_fb[x] != 0;
+  expect(drawn, "%s: the first line is not in the first frame", mode);
+  Cost all = cost(0, t.size());
+  expect(s.startup_us == all.us && micros() - beginUs == all.us, "%s: startup_us %u, bus time %u", mode,
+         (unsigned)s.startup_us, all.us);
+}
+
+// the render task's sequence (taskFunc), run inline
+void taskMode()
+{
+  OledLogger::Stats before;
+  OledLogger::getStats(before);
+  uint64_t beginUs = micros();
+  expect(begin(), "task: begin failed");
+  checkBegin("task");
+  OledLogger::logf("BOOT: first line");
+  size_t initEnd = Wire.transactions.size();
+
+  OledLogger::msg_t scratch;
+  OledLogger::startFrame(scratch);
+  OledLogger::flushDirty(false);
+  size_t frameEnd = Wire.transactions.size();
+  OledLogger::displayOn();
+  checkStartup("task", beginUs, before);
+
+  OledLogger::Stats s;
+  OledLogger::getStats(s);
+  printf("render task, 100 kHz: begin() to first line %.2f ms\n", s.startup_us / 1000.0);
+  report("probe", cost(0, 1));
+  report("init sequence", cost(1, initEnd));
+  report("first frame", cost(initEnd, frameEnd));
+  report("display on", cost(frameEnd, Wire.transactions.size()));
+  Cost all = cost(0, Wire.transactions.size());
+  report("total", all);
+}
+
+// polled mode: the first frame goes out a page per service() call
+void polledMode()
+{
+  OledLogger::Stats before;
+  OledLogger::getStats(before);
+  uint64_t beginUs = micros();
+  expect(begin(), "polled: begin failed");
+  checkBegin("polled");
+  OledLogger::logf("BOOT: first line");
+  int calls = 0;
+  while (!OledLogger::_started && calls < 100) {
+    OledLogger::service(0);
+    ++calls;
+  }
+  checkStartup("polled", beginUs, before);
+
+  OledLogger::Stats s;
+  OledLogger::getStats(s);
+  Cost all = cost(0, Wire.transactions.size());
+  printf("polled, 100 kHz: begin() to first line %.2f ms in %d service() calls\n", s.startup_us / 1000.0,
+         calls);
+  report("total", all);
+}
+
+// after startup, service(0) still drains one record per call
+void zeroBudget()
+{
+  OledLogger::logf("second");
+  OledLogger::logf("third");
+  OledLogger::service(0);
+  expect(uxQueueMessagesWaiting(OledLogger::_queue) == 1, "service(0) drained %u records",
+         2 - (unsigned)uxQueueMessagesWaiting(OledLogger::_queue));
+  OledLogger::service(0);
+  expect(uxQueueMessagesWaiting(OledLogger::_queue) == 0, "second service(0) drained nothing");
+}
+
+} // namespace
+
+int main()
+{
+  taskMode();
+  polledMode();
+  zeroBudget();
+
+  if (failures) {
+    printf("startup_test: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("startup_test: ok\n");
+  return 0;
+}
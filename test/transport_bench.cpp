@@ -0,0 +1,145 @@
+// Host benchmark: the three FreeRTOS/ESP-IDF transports a log record could
+// take (queue of fixed msg_t items, no-split ring buffer, message buffer),
+// on the models in host/freertos/. RAM per record uses the device's item
+// overheads and is exact; the timings are the host models' and only rank
+// the copies each transport makes (queue: the whole msg_t in and out, ring
+// buffer: the used bytes in, read in place, message buffer: the used bytes
+// in and out).
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+#include "Arduino.h"
+#include "Wire.h"
+#include "freertos/message_buffer.h"
+#include "freertos/ringbuf.h"
+// records are built and sized the way the logger does
+#define private public
+#include "OledLogger.h"
+#undef private
+
+namespace {
+
+typedef OledLogger::msg_t msg_t;
+
+const size_t QUEUE_LEN = 16; // begin() default
+const int ROUNDS = 200000;
+const int BATCH = 8;         // records per drain, well within every transport
+
+// a log mix: short status lines to full-width ones
+const int LENGTHS[] = { 8, 14, 21, 21, 32, 44, 63 };
+const int MIX = sizeof(LENGTHS) / sizeof(LENGTHS[0]);
+msg_t records[MIX];
+size_t sizes[MIX];
+volatile int sink;
+
+void makeRecords()
+{
+  for (int i = 0; i < MIX; ++i) {
+    msg_t& m = records[i];
+    memset(&m, 0, sizeof(m));
+    m.kind = OledLogger::MSG_TEXT;
+    m.level = OledLogger::LEVEL_INFO;
+    memset(m.txt, 'a' + i, LENGTHS[i]);
+    m.txt[LENGTHS[i]] = '\0';
+    sizes[i] = OledLogger::recordSize(m);
+  }
+}
+
+template <typename F>
+double nsPerRecord(F f)
+{
+  auto t0 = std::chrono::steady_clock::now();
+  for (int r = 0; r < ROUNDS; ++r) f(r);
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() / ROUNDS / BATCH;
+}
+
+// records of the mix that fit before the first send fails
+template <typename Send>
+int capacity(Send send)
+{
+  int n = 0;
+  while (send(n % MIX)) ++n;
+  return n;
+}
+
+void report(const char* name, size_t ram, int held, double ns)
+{
+  printf("%-16s %5zu B  %3d records held  %5.1f B/record  %6.1f ns/record (host)\n", name, ram, held,
+         (double)ram / held, ns);
+}
+
+} // namespace
+
+int main()
+{
+  makeRecords();
+  double used = 0;
+  for (int i = 0; i < MIX; ++i) used += sizes[i];
+  printf("record mix: %d lengths, %.1f used bytes on average, msg_t is %zu bytes\n", MIX, used / MIX,
+         sizeof(msg_t));
+
+  // queue: fixed sizeof(msg_t) items, copied in and out
+  {
+    const size_t ram = QUEUE_LEN * sizeof(msg_t);
+    QueueHandle_t q = xQueueCreate(QUEUE_LEN, sizeof(msg_t));
+    int held = capacity([&](int i) { return xQueueSend(q, &records[i], 0) == pdTRUE; });
+    msg_t scratch;
+    while (xQueueReceive(q, &scratch, 0) == pdTRUE) {}
+    double ns = nsPerRecord([&](int r) {
+      for (int i = 0; i < BATCH; ++i) xQueueSend(q, &records[(r + i) % MIX], 0);
+      int s = 0;
+      while (xQueueReceive(q, &scratch, 0) == pdTRUE) s += scratch.txt[0];
+      sink = s;
+    });
+    report("queue", ram, held, ns);
+    vQueueDelete(q);
+  }
+
+  // ring buffer, sized as createTransport() does: used bytes plus an
+  // 8-byte header, 4-byte aligned; read in place
+  {
+    const size_t ram = QUEUE_LEN * ((sizeof(msg_t) + 8 + 3) & ~(size_t)3);
+    RingbufHandle_t rb = xRingbufferCreate(ram, RINGBUF_TYPE_NOSPLIT);
+    int held = capacity([&](int i) { return xRingbufferSend(rb, &records[i], sizes[i], 0) == pdTRUE; });
+    size_t size;
+    while (void* p = xRingbufferReceive(rb, &size, 0)) vRingbufferReturnItem(rb, p);
+    double ns = nsPerRecord([&](int r) {
+      for (int i = 0; i < BATCH; ++i) {
+        int k = (r + i) % MIX;
+        xRingbufferSend(rb, &records[k], sizes[k], 0);
+      }
+      int s = 0;
+      while (void* p = xRingbufferReceive(rb, &size, 0)) {
+        s += ((const msg_t*)p)->txt[0];
+        vRingbufferReturnItem(rb, p);
+      }
+      sink = s;
+    });
+    report("ring buffer", ram, held, ns);
+    vRingbufferDelete(rb);
+  }
+
+  // message buffer, same storage: used bytes plus a 4-byte length, copied
+  // in and out
+  {
+    const size_t ram = QUEUE_LEN * ((sizeof(msg_t) + 8 + 3) & ~(size_t)3);
+    MessageBufferHandle_t mb = xMessageBufferCreate(ram);
+    int held = capacity([&](int i) { return xMessageBufferSend(mb, &records[i], sizes[i], 0) == sizes[i]; });
+    msg_t scratch;
+    while (xMessageBufferReceive(mb, &scratch, sizeof(scratch), 0)) {}
+    double ns = nsPerRecord([&](int r) {
+      for (int i = 0; i < BATCH; ++i) {
+        int k = (r + i) % MIX;
+        xMessageBufferSend(mb, &records[k], sizes[k], 0);
+      }
+      int s = 0;
+      while (xMessageBufferReceive(mb, &scratch, sizeof(scratch), 0)) s += scratch.txt[0];
+      sink = s;
+    });
+    report("message buffer", ram, held, ns);
+    vMessageBufferDelete(mb);
+  }
+  return 0;
+}
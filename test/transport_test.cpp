@@ -0,0 +1,202 @@
+// Ring buffer transport (OLED_TRANSPORT_RINGBUF) on the host model in
+// host/freertos/ringbuf.h: the drop oldest policy must stay bounded, never
+// evict control records, never empty the ring, and leave the record the
+// render side holds (zero-copy) alone.
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "Arduino.h"
+#include "Wire.h"
+// the transport and its control counter are private
+#define private public
+#include "OledLogger.h"
+#undef private
+
+#if OLED_LOGGER_TRANSPORT != OLED_TRANSPORT_RINGBUF
+#error "build with -DOLED_LOGGER_TRANSPORT=OLED_TRANSPORT_RINGBUF"
+#endif
+
+namespace {
+
+int failures = 0;
+
+void expect(bool ok, const char* what, ...)
+{
+  if (ok) return;
+  ++failures;
+  va_list ap;
+  va_start(ap, what);
+  printf("FAIL ");
+  vprintf(what, ap);
+  printf("\n");
+  va_end(ap);
+}
+
+const size_t QUEUE_LEN = 8;
+
+std::vector<std::string> seen;
+
+void record(OledLogger::Level level, uint8_t tag, const char* text, void* ctx)
+{
+  (void)level; (void)tag; (void)ctx;
+  seen.push_back(text);
+}
+
+UBaseType_t waiting()
+{
+  UBaseType_t n = 0;
+  vRingbufferGetInfo(OledLogger::_queue, nullptr, nullptr, nullptr, nullptr, &n);
+  return n;
+}
+
+// everything queued, in order
+void drain()
+{
+  seen.clear();
+  while (waiting()) OledLogger::service(100000);
+}
+
+// headless polled logger (no panel on the bus): records only reach
+// history and subscribers
+void start(OledLogger::Subscriber fn, size_t history = 0)
+{
+  // there is no end(): drop the last run's transport so history can change
+  if (OledLogger::_queue) OledLogger::deleteTransport();
+  OledLogger::setHistory(history);
+  Wire.reset();
+  Wire.devices.clear();
+  bool ok = OledLogger::begin(0x3C, 128, 64, -1, -1, QUEUE_LEN, 1, 1, false);
+  expect(ok && OledLogger::isHeadless(), "headless begin failed");
+  OledLogger::setPanelProbe(0);
+  static int sub = -1;
+  if (sub >= 0) OledLogger::unsubscribe(sub);
+  sub = OledLogger::subscribe(fn);
+}
+
+// fill the ring with short records; returns how many fit
+int fill()
+{
+  int n = 0;
+  UBaseType_t before;
+  do {
+    before = waiting();
+    OledLogger::logf("old %d", n++);
+  } while (waiting() > before);
+  drain();
+  for (int i = 0; i < n - 1; ++i) OledLogger::logf("old %d", i);
+  return n - 1;
+}
+
+// a full ring makes room for a long record by dropping a bounded number
+// of the oldest ones, and the rest stay in order
+void dropOldest()
+{
+  start(record);
+  int n = fill();
+  expect(n > (int)QUEUE_LEN, "short records should outnumber queue_len (%d)", n);
+  std::string longLine(60, 'L');
+  OledLogger::logf("%s", longLine.c_str());
+  expect(waiting() >= 1, "ring emptied");
+  drain();
+  int dropped = n + 1 - (int)seen.size();
+  expect(dropped >= 1 && dropped <= 8, "%d records dropped for one", dropped);
+  expect(!seen.empty() && seen.back() == longLine, "new record lost");
+  for (size_t i = 0; i + 1 < seen.size(); ++i) {
+    char want[16];
+    snprintf(want, sizeof(want), "old %d", dropped + (int)i);
+    expect(seen[i] == want, "order: '%s' at %zu, want '%s'", seen[i].c_str(), i, want);
+  }
+  printf("%-28s %d short records queued, %d dropped for a 60-character line\n", "drop oldest", n, dropped);
+}
+
+// a capture/view command may be the oldest record: the new one is dropped
+void controlPending()
+{
+  start(record);
+  int n = fill();
+  __atomic_store_n(&OledLogger::_ctlQueued, 1, __ATOMIC_RELEASE);
+  OledLogger::logf("new");
+  __atomic_store_n(&OledLogger::_ctlQueued, 0, __ATOMIC_RELEASE);
+  drain();
+  expect((int)seen.size() == n && seen.back() != "new", "control pending: %zu of %d kept", seen.size(), n);
+}
+
+// a subscriber logging from its callback while the render side holds the
+// record being delivered: dropping older records frees nothing, so the new
+// ones are dropped and the ring keeps what it had
+int burstSeen;
+UBaseType_t burstWaiting;
+bool heldIntact;
+
+void burst(OledLogger::Level level, uint8_t tag, const char* text, void* ctx)
+{
+  record(level, tag, text, ctx);
+  if (strcmp(text, "trigger")) return;
+  for (int i = 0; i < 4 * (int)QUEUE_LEN; ++i) OledLogger::logf("burst %d", i);
+  burstWaiting = waiting();
+  heldIntact = !strcmp(text, "trigger");
+}
+
+void burstWhileHeld()
+{
+  start(burst);
+  OledLogger::logf("trigger");
+  seen.clear();
+  OledLogger::service(100000);
+  while (waiting()) OledLogger::service(100000);
+  burstSeen = 0;
+  for (size_t i = 0; i < seen.size(); ++i) {
+    char want[16];
+    snprintf(want, sizeof(want), "burst %d", burstSeen);
+    if (seen[i] == want) burstSeen++;
+  }
+  expect(heldIntact, "held record overwritten");
+  expect(burstWaiting >= QUEUE_LEN, "burst left %u records queued", (unsigned)burstWaiting);
+  expect(burstSeen == (int)seen.size() - 1, "burst records out of order or missing");
+  printf("%-28s %d of %d records kept, the held record intact\n", "burst from a subscriber", burstSeen,
+         4 * (int)QUEUE_LEN);
+}
+
+// a control record queued after the pending check (simulated by hiding the
+// count) is still the oldest: it goes back instead of being dropped
+void controlRequeued()
+{
+  start(record, 32);
+  expect(OledLogger::capture(OledLogger::Trigger(), 4), "capture not queued");
+  UBaseType_t before;
+  int n = 0;
+  do {
+    before = waiting();
+    OledLogger::logf("old %d", n++);
+  } while (waiting() > before);
+
+  __atomic_store_n(&OledLogger::_ctlQueued, 0, __ATOMIC_RELEASE);
+  OledLogger::logf("%s", std::string(60, 'L').c_str());
+  __atomic_store_n(&OledLogger::_ctlQueued, 1, __ATOMIC_RELEASE);
+  drain();
+  expect(OledLogger::_capState == OledLogger::CAP_ARMED, "capture command lost");
+  expect(__atomic_load_n(&OledLogger::_ctlQueued, __ATOMIC_ACQUIRE) == 0, "control count %u after drain",
+         (unsigned)OledLogger::_ctlQueued);
+  OledLogger::resume();
+  drain();
+}
+
+} // namespace
+
+int main()
+{
+  dropOldest();
+  controlPending();
+  controlRequeued();
+  burstWhileHeld();
+
+  if (failures) {
+    printf("transport_test: %d failure(s)\n", failures);
+    return 1;
+  }
+  printf("transport_test: ok\n");
+  return 0;
+}
@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""Format-string dictionary for OledLogger interned ids.
+
+Scans sources for OLED_LOG* macro calls, hashes the format literal with the
+same 16-bit folded FNV-1a as OledFmtId.h and writes an id -> format JSON
+dictionary. With `decode`, expands "#<id> <arg>..." lines posted by builds
+using OLED_LOGGER_STRIP_FORMATS back into formatted text.
+
+  oled_fmt_dict.py build src/ examples/ -o fmt_dict.json
+  oled_fmt_dict.py decode fmt_dict.json < serial_capture.txt
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+FNV_OFFSET = 2166136261
+FNV_PRIME = 16777619
+
+MACRO_RE = re.compile(r'\bOLED_LOG\w*\s*\(')
+LITERAL_RE = re.compile(r'\s*"((?:[^"\\]|\\.)*)"')
+# one format piece: a string literal or an identifier (string macro)
+PIECE_RE = re.compile(r'\s*(?:"((?:[^"\\]|\\.)*)"|([A-Za-z_]\w*))')
+STRING_DEFINE_RE = re.compile(r'^\s*#\s*define\s+([A-Za-z_]\w*)\s+((?:"(?:[^"\\]|\\.)*"\s*)+)$',
+                              re.MULTILINE)
+# C conversion spec; length modifiers have no Python equivalent
+CONV_RE = re.compile(r'%([-+ #0]*)(\*|\d+)?(\.(?:\*|\d+)?)?(?:hh|h|ll|l|z|j|t|L)?([diouxXeEfFgGcsp%])')
+SIMPLE_ESCAPES = {'n': 10, 't': 9, 'r': 13, '\\': 92, '"': 34,
+                  "'": 39, 'a': 7, 'b': 8, 'f': 12, 'v': 11, '?': 63}
+SOURCE_EXTS = ('.c', '.cc', '.cpp', '.h', '.hpp', '.ino')
+
+
+def fmt_id(data):
+    h = FNV_OFFSET
+    for b in data:
+        h = ((h ^ b) * FNV_PRIME) & 0xFFFFFFFF
+    folded = (h >> 16) ^ (h & 0xFFFF)
+    return folded or 1
+
+
+def unescape(body):
+    out = bytearray()
+    i = 0
+    while i < len(body):
+        c = body[i]
+        if c != '\\':
+            out += c.encode('utf-8')
+            i += 1
+            continue
+        nxt = body[i + 1]
+        if nxt == 'x':
+            m = re.match(r'[0-9a-fA-F]+', body[i + 2:])
+            out.append(int(m.group(0), 16) & 0xFF)
+            i += 2 + len(m.group(0))
+        elif nxt in '01234567':
+            m = re.match(r'[0-7]{1,3}', body[i + 1:])
+            out.append(int(m.group(0), 8) & 0xFF)
+            i += 1 + len(m.group(0))
+        else:
+            out.append(SIMPLE_ESCAPES.get(nxt, ord(nxt)))
+            i += 2
+    return bytes(out)
+
+
+def call_args(text, pos):
+    """Top-level arguments of the call whose '(' ends at pos."""
+    args = []
+    depth = 0
+    start = q = pos
+    while q < len(text):
+        c = text[q]
+        if c == '"' or c == "'":
+            m = re.compile(r'%s(?:[^%s\\]|\\.)*%s' % (c, c, c)).match(text, q)
+            q = m.end() if m else q + 1
+            continue
+        if c in '([{':
+            depth += 1
+        elif c in ')]}':
+            if depth == 0:
+                args.append(text[start:q])
+                return args
+            depth -= 1
+        elif c == ',' and depth == 0:
+            args.append(text[start:q])
+            start = q + 1
+        q += 1
+    return None
+
+
+def string_defines(text):
+    """#define NAME "literal" ... -> unescaped bytes (e.g. the OLED_ICON_* codes)."""
+    defines = {}
+    for m in STRING_DEFINE_RE.finditer(text):
+        defines[m.group(1)] = b''.join(unescape(l.group(1))
+                                       for l in LITERAL_RE.finditer(m.group(2)))
+    return defines
+
+
+def format_literal(text, pos, defines):
+    """Bytes of the format argument of the call at pos.
+
+    The format is the first argument made of string literals and string
+    macros. Returns None if there is none, raises ValueError if that argument
+    uses an identifier that is not a known string macro (its hash would not
+    match the firmware's).
+    """
+    args = call_args(text, pos)
+    if args is None:
+        return None
+    for arg in args:
+        if '"' not in arg and not any(re.search(r'\b%s\b' % n, arg) for n in defines):
+            continue
+        data = b''
+        q = 0
+        while q < len(arg.rstrip()):
+            m = PIECE_RE.match(arg, q)
+            if not m:
+                raise ValueError('format is not a plain literal: %s' % arg.strip())
+            if m.group(2) is not None:
+                if m.group(2) not in defines:
+                    raise ValueError('unknown macro %s in format %s' % (m.group(2), arg.strip()))
+                data += defines[m.group(2)]
+            else:
+                data += unescape(m.group(1))
+            q = m.end()
+        return data
+    return None
+
+
+def scan(paths):
+    """Returns ({format bytes: path}, error count)."""
+    sources = {}
+    for root in paths:
+        files = [root] if os.path.isfile(root) else [
+            os.path.join(d, f) for d, _, fs in os.walk(root) for f in fs]
+        for path in files:
+            if path.endswith(SOURCE_EXTS):
+                with open(path, encoding='utf-8', errors='replace') as fh:
+                    sources[path] = fh.read()
+
+    # string macros usable in formats: the library's icon codes plus any
+    # defined in the scanned sources
+    font = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'src', 'OledFont.h')
+    defines = {}
+    if os.path.isfile(font):
+        with open(font, encoding='utf-8', errors='replace') as fh:
+            defines.update(string_defines(fh.read()))
+    for text in sources.values():
+        defines.update(string_defines(text))
+
+    formats = {}
+    errors = 0
+    for path, text in sorted(sources.items()):
+        if path.endswith('OledLogger.h'):
+            continue
+        for m in MACRO_RE.finditer(text):
+            try:
+                data = format_literal(text, m.end(), defines)
+            except ValueError as e:
+                line = text.count('\n', 0, m.start()) + 1
+                print('%s:%d: %s' % (path, line, e), file=sys.stderr)
+                errors += 1
+                continue
+            if data is not None:
+                formats.setdefault(data, path)
+    return formats, errors
+
+
+def build(args):
+    ids = {}
+    formats, errors = scan(args.paths)
+    collisions = 0
+    for data, path in sorted(formats.items()):
+        key = '0x%04X' % fmt_id(data)
+        fmt = data.decode('utf-8', errors='replace')
+        if key in ids and ids[key] != fmt:
+            print('collision %s: %r (%s) vs %r' % (key, fmt, path, ids[key]), file=sys.stderr)
+            collisions += 1
+            continue
+        ids[key] = fmt
+    out = json.dumps({'hash': 'fnv1a32-xorfold16', 'ids': ids}, indent=2, sort_keys=True)
+    if args.output:
+        with open(args.output, 'w') as fh:
+            fh.write(out + '\n')
+    else:
+        print(out)
+    return 1 if collisions or errors else 0
+
+
+def py_format(fmt):
+    """C format -> Python %-format: drop length modifiers, %p as hex."""
+    def conv(m):
+        flags, width, prec, c = m.group(1), m.group(2) or '', m.group(3) or '', m.group(4)
+        if c == 'p':
+            return '%#' + flags.replace('#', '') + width + 'x'
+        return '%' + flags + width + prec + c
+    return CONV_RE.sub(conv, fmt)
+
+
+def convert(token):
+    for cast in (int, float):
+        try:
+            return cast(token)
+        except ValueError:
+            pass
+    return token
+
+
+def decode(args):
+    with open(args.dictionary) as fh:
+        ids = {int(k, 16): v for k, v in json.load(fh)['ids'].items()}
+    for line in sys.stdin:
+        m = re.search(r'#([0-9A-F]{4})((?: \S+)*)', line)
+        if not m or int(m.group(1), 16) not in ids:
+            sys.stdout.write(line)
+            continue
+        fmt = py_format(ids[int(m.group(1), 16)])
+        values = tuple(convert(t) for t in m.group(2).split())
+        text, used = fmt + ' <' + ' '.join(str(v) for v in values) + '>', len(values)
+        # string args may contain spaces or be followed by other text: take the
+        # longest prefix of tokens the format accepts
+        for n in range(len(values), -1, -1):
+            try:
+                text, used = fmt % values[:n], n
+                break
+            except (TypeError, ValueError):
+                pass
+        rest = ' '.join(m.group(2).split()[used:])
+        sys.stdout.write(line[:m.start()] + text + (' ' + rest if rest else '') + line[m.end():])
+    return 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = ap.add_subparsers(dest='cmd', required=True)
+    b = sub.add_parser('build', help='scan sources and write the id dictionary')
+    b.add_argument('paths', nargs='+')
+    b.add_argument('-o', '--output')
+    d = sub.add_parser('decode', help='expand stripped "#id args" lines from stdin')
+    d.add_argument('dictionary')
+    args = ap.parse_args()
+    return build(args) if args.cmd == 'build' else decode(args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""Audit that the OledLogger ISR path stays out of flash.
+
+Reads the linked firmware ELF with the toolchain's objdump. Starting from
+the ISR entry points, it follows direct calls and reports:
+  - functions placed outside IRAM (anything not in ROM or an .iram section)
+  - literal-pool loads (l32r) whose literal, read from the ELF image, is an
+    address in flash-mapped data (DROM), e.g. a string that is not DRAM_ATTR
+  - indirect calls (callx), which cannot be followed and need a manual look
+
+  oled_iram_audit.py build/app.elf
+  oled_iram_audit.py --target esp32s3 --objdump xtensa-esp32s3-elf-objdump app.elf
+
+Exit status is 1 if anything on the path is flash-resident.
+"""
+
+import argparse
+import re
+import struct
+import subprocess
+import sys
+
+ROOTS = (
+    'OledLogger::logFromISR',
+    'OledLogger::triggerFromISR',
+    'OledLogger::sample',
+    'OledLogger::setWidget',
+)
+
+# (ROM text, flash-mapped data) address ranges per target
+TARGETS = {
+    'esp32':   ((0x40000000, 0x40070000), (0x3F400000, 0x3F800000)),
+    'esp32s3': ((0x40000000, 0x40060000), (0x3C000000, 0x3E000000)),
+}
+
+SYM_RE = re.compile(r'^([0-9a-f]+)\s+(\S)\s*(\S*)\s+(\S+)\s+([0-9a-f]+)\s+(.*)$')
+CALL_RE = re.compile(r'\s(call(?:0|4|8|12))\s+([0-9a-f]+)\s+<([^>]+)>')
+CALLX_RE = re.compile(r'\s(callx(?:0|4|8|12))\s')
+# objdump prints the literal's address, not its value: l32r a8, 400d0f10 <..>
+L32R_RE = re.compile(r'\sl32r\s+\w+,\s*([0-9a-f]+)')
+
+SHT_PROGBITS = 1
+SHF_ALLOC = 0x2
+
+
+class Image:
+    """Loaded contents of an ELF's allocated sections, for reading literals."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            self.data = f.read()
+        if self.data[:4] != b'\x7fELF':
+            raise ValueError('%s: not an ELF file' % path)
+        wide = self.data[4] == 2
+        self.endian = '<' if self.data[5] == 1 else '>'
+        if wide:
+            shoff, = struct.unpack_from(self.endian + 'Q', self.data, 0x28)
+            shentsize, shnum = struct.unpack_from(self.endian + 'HH', self.data, 0x3A)
+            shdr = self.endian + 'IIQQQQ'
+        else:
+            shoff, = struct.unpack_from(self.endian + 'I', self.data, 0x20)
+            shentsize, shnum = struct.unpack_from(self.endian + 'HH', self.data, 0x2E)
+            shdr = self.endian + 'IIIIII'
+        # (address, file offset, size) of every section that is loaded as-is
+        self.sections = []
+        for i in range(shnum):
+            _, kind, flags, addr, offset, size = struct.unpack_from(
+                shdr, self.data, shoff + i * shentsize)
+            if kind == SHT_PROGBITS and flags & SHF_ALLOC and size:
+                self.sections.append((addr, offset, size))
+
+    def word(self, addr):
+        """The 32-bit word stored at addr, or None if no section holds it."""
+        for start, offset, size in self.sections:
+            if start <= addr and addr + 4 <= start + size:
+                return struct.unpack_from(self.endian + 'I', self.data,
+                                          offset + addr - start)[0]
+        return None
+
+
+def symbols(objdump, elf):
+    """name -> (address, size, section) for function symbols."""
+    out = subprocess.run([objdump, '-t', '-C', elf], check=True,
+                         capture_output=True, text=True).stdout
+    table = {}
+    for line in out.splitlines():
+        m = SYM_RE.match(line)
+        if not m or 'F' not in m.group(3):
+            continue
+        addr, section, size, name = int(m.group(1), 16), m.group(4), int(m.group(5), 16), m.group(6)
+        # drop the parameter list so roots match any overload
+        table.setdefault(name.split('(')[0], []).append((addr, size, section))
+        table.setdefault(name, []).append((addr, size, section))
+    return table
+
+
+def disassemble(objdump, elf, addr, size):
+    return subprocess.run([objdump, '-d', '-C', '--start-address=%#x' % addr,
+                           '--stop-address=%#x' % (addr + size), elf],
+                          check=True, capture_output=True, text=True).stdout
+
+
+def in_range(addr, rng):
+    return rng[0] <= addr < rng[1]
+
+
+def audit(args):
+    rom, drom = TARGETS[args.target]
+    table = symbols(args.objdump, args.elf)
+    image = Image(args.elf)
+    by_addr = {}
+    for name, entries in table.items():
+        for addr, size, section in entries:
+            by_addr.setdefault(addr, (name, size, section))
+
+    problems = 0
+    seen = set()
+    work = []
+    for root in ROOTS:
+        if root not in table:
+            print('note: %s not linked' % root)
+            continue
+        work.extend(addr for addr, _, _ in table[root])
+
+    while work:
+        addr = work.pop()
+        if addr in seen:
+            continue
+        seen.add(addr)
+        if in_range(addr, rom):
+            continue
+        name, size, section = by_addr.get(addr, ('<%#x>' % addr, 0, '?'))
+        if not section.startswith('.iram'):
+            print('FLASH  %-50s %s' % (name, section))
+            problems += 1
+            continue
+        print('iram   %-50s %s' % (name, section))
+        if not size:
+            continue
+        for line in disassemble(args.objdump, args.elf, addr, size).splitlines():
+            m = CALL_RE.search(line)
+            if m:
+                work.append(int(m.group(2), 16))
+                continue
+            if CALLX_RE.search(line):
+                print('  indirect call in %s: %s' % (name, line.strip()))
+                continue
+            m = L32R_RE.search(line)
+            if not m:
+                continue
+            value = image.word(int(m.group(1), 16))
+            if value is None:
+                print('  unreadable literal in %s: %s' % (name, line.strip()))
+            elif in_range(value, drom):
+                print('  flash constant %#x loaded in %s: %s' % (value, name, line.strip()))
+                problems += 1
+
+    print('%d function(s) checked, %d problem(s)' % (len(seen), problems))
+    return 1 if problems else 0
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument('elf')
+    ap.add_argument('--target', choices=sorted(TARGETS), default='esp32')
+    ap.add_argument('--objdump', help='objdump to use (default: xtensa-<target>-elf-objdump)')
+    args = ap.parse_args()
+    if not args.objdump:
+        args.objdump = 'xtensa-%s-elf-objdump' % args.target
+    return audit(args)
+
+
+if __name__ == '__main__':
+    sys.exit(main())